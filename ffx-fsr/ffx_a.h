@@ -52,6 +52,7 @@
 // A_HLSL_6_2  Using HLSL 6.2 with new 'uint16_t' and related types (requires '-enable-16bit-types').
 // A_NO_16_BIT_CAST Don't use instructions that are not availabe in SPIR-V (needed for running A_HLSL_6_2 on Vulkan)
 // A_GCC ..... Using a GCC compatible compiler (else assume MSVC compatible compiler by default).
+// A_SSE ..... Using SSE intrinsics in CPU code (include '<xmmintrin.h>' first).
 // =======
 // A_BYTE .... Support 8-bit integer.
 // A_HALF .... Support 16-bit integer and floating point.
@@ -115,6 +116,13 @@
  #ifndef A_STATIC
   #define A_STATIC static
  #endif
+//------------------------------------------------------------------------------------------------------------------------------
+ // Compile time evaluation needs C++14 relaxed constexpr, the '*Ct()' functions are only provided when this is defined.
+ #ifndef A_CONSTEXPR
+  #if defined(__cplusplus)&&((__cplusplus>=201402L)||(defined(_MSVC_LANG)&&(_MSVC_LANG>=201402L)))
+   #define A_CONSTEXPR static constexpr
+  #endif
+ #endif
 //------------------------------------------------------------------------------------------------------------------------------
  // Same types across CPU and GPU.
  // Predicate uses 32-bit integer (C friendly bool).
@@ -139,6 +147,7 @@
  #define ASU1_(a) ((ASU1)(a))
 //------------------------------------------------------------------------------------------------------------------------------
  A_STATIC AU1 AU1_AF1(AF1 a){union{AF1 f;AU1 u;}bits;bits.f=a;return bits.u;}
+ A_STATIC AF1 AF1_AU1(AU1 a){union{AF1 f;AU1 u;}bits;bits.u=a;return bits.f;}
 //------------------------------------------------------------------------------------------------------------------------------
  #define A_TRUE 1
  #define A_FALSE 0
@@ -471,6 +480,50 @@
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //_____________________________________________________________/\_______________________________________________________________
 //==============================================================================================================================
+//                                                 RECIPROCAL PRECISION TIERS
+//==============================================================================================================================
+// The GPU 'APrx*RcpF1()' integer tricks are tuned for GPU ALUs, on x86 the better mix is 'rcpps' plus 0 or 1 Newton steps.
+// Pick the tier per call site, passing a literal tier lets the compiler fold the switch away.
+//  A_RCP_FAST .... Hardware estimate only with A_SSE (12 bits), else the 'APrxLoRcpF1()' bit trick.
+//  A_RCP_MEDIUM .. Estimate plus one Newton-Raphson step (22 bits with A_SSE).
+//  A_RCP_EXACT ... Divide.
+// Use 'tools/fsr_rcp_bench' to measure throughput and maximum relative error of each tier on the target machine.
+//------------------------------------------------------------------------------------------------------------------------------
+// Only positive finite inputs are supported by the non-exact tiers.
+//==============================================================================================================================
+ #define A_RCP_FAST 0
+ #define A_RCP_MEDIUM 1
+ #define A_RCP_EXACT 2
+//------------------------------------------------------------------------------------------------------------------------------
+ #ifdef A_SSE
+  A_STATIC __m128 ARcpTierF4(__m128 a,AU1 tier){
+   if(tier==A_RCP_EXACT)return _mm_div_ps(_mm_set1_ps(1.0f),a);
+   __m128 b=_mm_rcp_ps(a);
+   if(tier==A_RCP_FAST)return b;
+   // b*(2-b*a) written as (b+b)-(b*b)*a to keep both multiplies independent.
+   return _mm_sub_ps(_mm_add_ps(b,b),_mm_mul_ps(_mm_mul_ps(b,b),a));}
+//------------------------------------------------------------------------------------------------------------------------------
+  A_STATIC AF1 ARcpTierF1(AF1 a,AU1 tier){
+   if(tier==A_RCP_EXACT)return 1.0f/a;
+   return _mm_cvtss_f32(ARcpTierF4(_mm_set_ss(a),tier));}
+ #else
+  A_STATIC AF1 ARcpTierF1(AF1 a,AU1 tier){
+   if(tier==A_RCP_EXACT)return 1.0f/a;
+   if(tier==A_RCP_FAST)return AF1_AU1(AU1_(0x7ef07ebb)-AU1_AF1(a));
+   AF1 b=AF1_AU1(AU1_(0x7ef19fff)-AU1_AF1(a));return b*(-b*a+2.0f);}
+ #endif
+//------------------------------------------------------------------------------------------------------------------------------
+ // Array form for CPU kernels, 'd' and 'a' may alias.
+ A_STATIC void ARcpTierArrayF1(AF1*d,const AF1*a,AU1 n,AU1 tier){
+  AU1 i=0;
+  #ifdef A_SSE
+   for(;i+4<=n;i+=4)_mm_storeu_ps(d+i,ARcpTierF4(_mm_loadu_ps(a+i),tier));
+  #endif
+  for(;i<n;i++)d[i]=ARcpTierF1(a[i],tier);}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//_____________________________________________________________/\_______________________________________________________________
+//==============================================================================================================================
 //                                                     HALF FLOAT PACKING
 //==============================================================================================================================
  // Convert float to half (in lower 16-bits of output).
@@ -550,6 +603,65 @@
 //------------------------------------------------------------------------------------------------------------------------------
  // Used to output packed constant.
  A_STATIC AU1 AU1_AH2_AF2(inAF2 a){return AU1_AH1_AF1(a[0])+(AU1_AH1_AF1(a[1])<<16);}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//_____________________________________________________________/\_______________________________________________________________
+//==============================================================================================================================
+//                                                COMPILE TIME CONSTANT EVALUATION
+//==============================================================================================================================
+// Versions of the above which can be evaluated by the compiler, used to bake constant blocks into static tables.
+// Results are bit identical to the runtime versions, the exponential is only defined for finite inputs.
+// It can differ by at most 1 ULP when the platform 'exp2f()' is not correctly rounded.
+//==============================================================================================================================
+ #ifdef A_CONSTEXPR
+  // A compile time bit cast, where the compiler has one, is the only way to see the sign of -0.0 (1.0/-0.0 is not a constant).
+  #if defined(__has_builtin)
+   #if __has_builtin(__builtin_bit_cast)
+    #define A_BIT_CAST_CT 1
+   #endif
+  #endif
+  #if defined(_MSC_VER)&&(_MSC_VER>=1926)&&!defined(A_BIT_CAST_CT)
+   #define A_BIT_CAST_CT 1
+  #endif
+  A_CONSTEXPR AF1 ARcpF1Ct(AF1 a){return 1.0f/a;}
+//------------------------------------------------------------------------------------------------------------------------------
+  // Splits off the integer part which is applied as an exact power of two, fraction uses a double precision series.
+  A_CONSTEXPR AF1 AExp2F1Ct(AF1 a){
+   AD1 x=AD1_(a);AD1 i=AD1_(ASL1_(x));if(i>x)i-=1.0;
+   AD1 f=(x-i)*0.6931471805599453;AD1 t=1.0;AD1 r=1.0;
+   for(ASU1 n=1;n<24;n++){t*=f/AD1_(n);r+=t;}
+   for(;i>0.0;i-=1.0)r*=2.0;
+   for(;i<0.0;i+=1.0)r*=0.5;
+   return AF1_(r);}
+//------------------------------------------------------------------------------------------------------------------------------
+  // Without a compile time bit cast the bit pattern is reconstructed with exact power of two scaling instead of a union.
+  // INF keeps its sign, NaN returns the quiet NaN 0x7fc00000 and negative zero returns positive zero in that case.
+  A_CONSTEXPR AU1 AU1_AF1Ct(AF1 a){
+  #ifdef A_BIT_CAST_CT
+   return __builtin_bit_cast(AU1,a);}
+  #else
+   if(a!=a)return AU1_(0x7fc00000);
+   AU1 s=AU1_(0);if(a<0.0f){s=AU1_(0x80000000);a=-a;}
+   if(a==0.0f)return s;
+   if(a>3.402823466e+38f)return s|AU1_(0x7f800000);
+   ASU1 e=0;
+   while(a>=2.0f){a*=0.5f;e++;}
+   while((a<1.0f)&&(e>-126)){a*=2.0f;e--;}
+   // Denormal.
+   if(a<1.0f)return s|AU1_(a*8388608.0f);
+   return s|(AU1_(e+127)<<23)|AU1_((a-1.0f)*8388608.0f);}
+  #endif
+//------------------------------------------------------------------------------------------------------------------------------
+  // Computes the same 'base' and 'shift' as the tables in 'AU1_AH1_AF1()'.
+  A_CONSTEXPR AU1 AU1_AH1_AF1Ct(AF1 f){
+   AU1 u=AU1_AF1Ct(f);AU1 e=(u>>23)&AU1_(0xff);AU1 s=(u>>16)&AU1_(0x8000);AU1 m=u&AU1_(0x7fffff);
+   if(e<AU1_(103))return s;
+   if(e<AU1_(113))return s+(AU1_(1)<<(e-AU1_(103)))+(m>>(AU1_(126)-e));
+   if(e<AU1_(143))return s+((e-AU1_(112))<<10)+(m>>13);
+   return s+AU1_(0x7bff);}
+//------------------------------------------------------------------------------------------------------------------------------
+  A_CONSTEXPR AU1 AU1_AH2_AF2Ct(AF1 a,AF1 b){return AU1_AH1_AF1Ct(a)+(AU1_AH1_AF1Ct(b)<<16);}
+ #endif
 #endif
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -223,6 +223,38 @@ A_STATIC void FsrEasuConOffset(
     con0[2] = AU1_AF1(AF1_(0.5) * inputViewportInPixelsX * ARcpF1(outputSizeInPixelsX) - AF1_(0.5) + inputOffsetInPixelsX);
     con0[3] = AU1_AF1(AF1_(0.5) * inputViewportInPixelsY * ARcpF1(outputSizeInPixelsY) - AF1_(0.5) + inputOffsetInPixelsY);
 }
+//------------------------------------------------------------------------------------------------------------------------------
+// Compile time version for C++14 and later, used to bake constants for known resolution pairs into static tables.
+// Output is bit identical to 'FsrEasuCon()', and the members have the same layout as four consecutive 'AU4' constants.
+//  static constexpr FsrEasuConstants easu1440p=FsrEasuConCt(1920.0f,1080.0f,1920.0f,1080.0f,2560.0f,1440.0f);
+// Individual values can also be passed as template arguments (for example 'easu1440p.con0[0]').
+#ifdef A_CONSTEXPR
+ struct FsrEasuConstants{AU1 con0[4];AU1 con1[4];AU1 con2[4];AU1 con3[4];};
+ A_CONSTEXPR FsrEasuConstants FsrEasuConCt(
+ AF1 inputViewportInPixelsX,
+ AF1 inputViewportInPixelsY,
+ AF1 inputSizeInPixelsX,
+ AF1 inputSizeInPixelsY,
+ AF1 outputSizeInPixelsX,
+ AF1 outputSizeInPixelsY){
+  FsrEasuConstants c={};
+  c.con0[0]=AU1_AF1Ct(inputViewportInPixelsX*ARcpF1Ct(outputSizeInPixelsX));
+  c.con0[1]=AU1_AF1Ct(inputViewportInPixelsY*ARcpF1Ct(outputSizeInPixelsY));
+  c.con0[2]=AU1_AF1Ct(AF1_(0.5)*inputViewportInPixelsX*ARcpF1Ct(outputSizeInPixelsX)-AF1_(0.5));
+  c.con0[3]=AU1_AF1Ct(AF1_(0.5)*inputViewportInPixelsY*ARcpF1Ct(outputSizeInPixelsY)-AF1_(0.5));
+  c.con1[0]=AU1_AF1Ct(ARcpF1Ct(inputSizeInPixelsX));
+  c.con1[1]=AU1_AF1Ct(ARcpF1Ct(inputSizeInPixelsY));
+  c.con1[2]=AU1_AF1Ct(AF1_( 1.0)*ARcpF1Ct(inputSizeInPixelsX));
+  c.con1[3]=AU1_AF1Ct(AF1_(-1.0)*ARcpF1Ct(inputSizeInPixelsY));
+  c.con2[0]=AU1_AF1Ct(AF1_(-1.0)*ARcpF1Ct(inputSizeInPixelsX));
+  c.con2[1]=AU1_AF1Ct(AF1_( 2.0)*ARcpF1Ct(inputSizeInPixelsY));
+  c.con2[2]=AU1_AF1Ct(AF1_( 1.0)*ARcpF1Ct(inputSizeInPixelsX));
+  c.con2[3]=AU1_AF1Ct(AF1_( 2.0)*ARcpF1Ct(inputSizeInPixelsY));
+  c.con3[0]=AU1_AF1Ct(AF1_( 0.0)*ARcpF1Ct(inputSizeInPixelsX));
+  c.con3[1]=AU1_AF1Ct(AF1_( 4.0)*ARcpF1Ct(inputSizeInPixelsY));
+  c.con3[2]=c.con3[3]=0;
+  return c;}
+#endif
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //_____________________________________________________________/\_______________________________________________________________
@@ -594,6 +626,231 @@ A_STATIC void FsrEasuConOffset(
 #endif
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//_____________________________________________________________/\_______________________________________________________________
+//==============================================================================================================================
+//                                                    PACKED 16-BIT VERSION
+//==============================================================================================================================
+// Unlike FsrEasuH() which packs pairs of taps of one pixel, this runs two output pixels in lockstep.
+// Every operation after the gathers works on both pixels at once, including the direction analysis and normalization.
+#if defined(A_GPU)&&defined(A_HALF)&&defined(FSR_EASU_HX2)
+// Input callback prototypes, need to be implemented by calling shader
+ AH4 FsrEasuRHx2(AF2 p);
+ AH4 FsrEasuGHx2(AF2 p);
+ AH4 FsrEasuBHx2(AF2 p);
+//------------------------------------------------------------------------------------------------------------------------------
+ // Can be used to convert from packed Structures of Arrays to Arrays of Structures for store.
+ void FsrEasuDepackHx2(out AH4 pix0,out AH4 pix1,AH2 pixR,AH2 pixG,AH2 pixB){
+  #ifdef A_HLSL
+   // Invoke a slower path for DX only, since it won't allow uninitialized values.
+   pix0.a=pix1.a=0.0;
+  #endif
+  pix0.rgb=AH3(pixR.x,pixG.x,pixB.x);
+  pix1.rgb=AH3(pixR.y,pixG.y,pixB.y);}
+//------------------------------------------------------------------------------------------------------------------------------
+ // Same tap as FsrEasuTapF(), one pixel per lane.
+ void FsrEasuTapHx2(
+ inout AH2 aCR,inout AH2 aCG,inout AH2 aCB,
+ inout AH2 aW,
+ AH2 offX,AH2 offY,
+ AH2 dirX,AH2 dirY,
+ AH2 lenX,AH2 lenY,
+ AH2 lob,
+ AH2 clp,
+ AH2 cR,AH2 cG,AH2 cB){
+  AH2 vX,vY;
+  vX=offX*  dirX +offY*dirY;
+  vY=offX*(-dirY)+offY*dirX;
+  vX*=lenX;vY*=lenY;
+  AH2 d2=vX*vX+vY*vY;
+  d2=min(d2,clp);
+  AH2 wB=AH2_(2.0/5.0)*d2+AH2_(-1.0);
+  AH2 wA=lob*d2+AH2_(-1.0);
+  wB*=wB;
+  wA*=wA;
+  wB=AH2_(25.0/16.0)*wB+AH2_(-(25.0/16.0-1.0));
+  AH2 w=wB*wA;
+  aCR+=cR*w;aCG+=cG*w;aCB+=cB*w;aW+=w;}
+//------------------------------------------------------------------------------------------------------------------------------
+ // Same as FsrEasuSetF(), one pixel per lane, the bilinear weight 'w' is computed by the caller.
+ void FsrEasuSetHx2(
+ inout AH2 dirX,inout AH2 dirY,
+ inout AH2 len,
+ AH2 w,
+ AH2 lA,AH2 lB,AH2 lC,AH2 lD,AH2 lE){
+  AH2 dc=lD-lC;
+  AH2 cb=lC-lB;
+  AH2 lenX=max(abs(dc),abs(cb));
+  lenX=ARcpH2(lenX);
+  AH2 dX=lD-lB;
+  dirX+=dX*w;
+  lenX=ASatH2(abs(dX)*lenX);
+  lenX*=lenX;
+  len+=lenX*w;
+  AH2 ec=lE-lC;
+  AH2 ca=lC-lA;
+  AH2 lenY=max(abs(ec),abs(ca));
+  lenY=ARcpH2(lenY);
+  AH2 dY=lE-lA;
+  dirY+=dY*w;
+  lenY=ASatH2(abs(dY)*lenY);
+  lenY*=lenY;
+  len+=lenY*w;}
+//------------------------------------------------------------------------------------------------------------------------------
+ void FsrEasuHx2(
+ // Output values are for 2 8x8 tiles in a 16x8 region.
+ //  pix<R,G,B>.x =  left 8x8 tile
+ //  pix<R,G,B>.y = right 8x8 tile
+ // This enables later processing to easily be packed as well.
+ out AH2 pixR,
+ out AH2 pixG,
+ out AH2 pixB,
+ AU2 ip, // Integer pixel position in output of the left tile, the right tile is at ip+AU2(8,0).
+ AU4 con0, // Constants generated by FsrEasuCon().
+ AU4 con1,
+ AU4 con2,
+ AU4 con3){
+//------------------------------------------------------------------------------------------------------------------------------
+  // Position math stays in FP32 per pixel, same as the other versions.
+  AF2 pp0=AF2(ip)*AF2_AU2(con0.xy)+AF2_AU2(con0.zw);
+  AF2 pp1=AF2(ip+AU2(8,0))*AF2_AU2(con0.xy)+AF2_AU2(con0.zw);
+  AF2 fp0=floor(pp0);
+  AF2 fp1=floor(pp1);
+  pp0-=fp0;
+  pp1-=fp1;
+  AH2 ppX=AH2(pp0.x,pp1.x);
+  AH2 ppY=AH2(pp0.y,pp1.y);
+//------------------------------------------------------------------------------------------------------------------------------
+  AF2 p00=fp0*AF2_AU2(con1.xy)+AF2_AU2(con1.zw);
+  AF2 p01=p00+AF2_AU2(con2.xy);
+  AF2 p02=p00+AF2_AU2(con2.zw);
+  AF2 p03=p00+AF2_AU2(con3.xy);
+  AF2 p10=fp1*AF2_AU2(con1.xy)+AF2_AU2(con1.zw);
+  AF2 p11=p10+AF2_AU2(con2.xy);
+  AF2 p12=p10+AF2_AU2(con2.zw);
+  AF2 p13=p10+AF2_AU2(con3.xy);
+  AH4 bczzR0=FsrEasuRHx2(p00);
+  AH4 bczzG0=FsrEasuGHx2(p00);
+  AH4 bczzB0=FsrEasuBHx2(p00);
+  AH4 ijfeR0=FsrEasuRHx2(p01);
+  AH4 ijfeG0=FsrEasuGHx2(p01);
+  AH4 ijfeB0=FsrEasuBHx2(p01);
+  AH4 klhgR0=FsrEasuRHx2(p02);
+  AH4 klhgG0=FsrEasuGHx2(p02);
+  AH4 klhgB0=FsrEasuBHx2(p02);
+  AH4 zzonR0=FsrEasuRHx2(p03);
+  AH4 zzonG0=FsrEasuGHx2(p03);
+  AH4 zzonB0=FsrEasuBHx2(p03);
+  AH4 bczzR1=FsrEasuRHx2(p10);
+  AH4 bczzG1=FsrEasuGHx2(p10);
+  AH4 bczzB1=FsrEasuBHx2(p10);
+  AH4 ijfeR1=FsrEasuRHx2(p11);
+  AH4 ijfeG1=FsrEasuGHx2(p11);
+  AH4 ijfeB1=FsrEasuBHx2(p11);
+  AH4 klhgR1=FsrEasuRHx2(p12);
+  AH4 klhgG1=FsrEasuGHx2(p12);
+  AH4 klhgB1=FsrEasuBHx2(p12);
+  AH4 zzonR1=FsrEasuRHx2(p13);
+  AH4 zzonG1=FsrEasuGHx2(p13);
+  AH4 zzonB1=FsrEasuBHx2(p13);
+//------------------------------------------------------------------------------------------------------------------------------
+  // Convert to Structures of Arrays with one pixel per lane.
+  AH2 bR=AH2(bczzR0.x,bczzR1.x);AH2 bG=AH2(bczzG0.x,bczzG1.x);AH2 bB=AH2(bczzB0.x,bczzB1.x);
+  AH2 cR=AH2(bczzR0.y,bczzR1.y);AH2 cG=AH2(bczzG0.y,bczzG1.y);AH2 cB=AH2(bczzB0.y,bczzB1.y);
+  AH2 iR=AH2(ijfeR0.x,ijfeR1.x);AH2 iG=AH2(ijfeG0.x,ijfeG1.x);AH2 iB=AH2(ijfeB0.x,ijfeB1.x);
+  AH2 jR=AH2(ijfeR0.y,ijfeR1.y);AH2 jG=AH2(ijfeG0.y,ijfeG1.y);AH2 jB=AH2(ijfeB0.y,ijfeB1.y);
+  AH2 fR=AH2(ijfeR0.z,ijfeR1.z);AH2 fG=AH2(ijfeG0.z,ijfeG1.z);AH2 fB=AH2(ijfeB0.z,ijfeB1.z);
+  AH2 eR=AH2(ijfeR0.w,ijfeR1.w);AH2 eG=AH2(ijfeG0.w,ijfeG1.w);AH2 eB=AH2(ijfeB0.w,ijfeB1.w);
+  AH2 kR=AH2(klhgR0.x,klhgR1.x);AH2 kG=AH2(klhgG0.x,klhgG1.x);AH2 kB=AH2(klhgB0.x,klhgB1.x);
+  AH2 lR=AH2(klhgR0.y,klhgR1.y);AH2 lG=AH2(klhgG0.y,klhgG1.y);AH2 lB=AH2(klhgB0.y,klhgB1.y);
+  AH2 hR=AH2(klhgR0.z,klhgR1.z);AH2 hG=AH2(klhgG0.z,klhgG1.z);AH2 hB=AH2(klhgB0.z,klhgB1.z);
+  AH2 gR=AH2(klhgR0.w,klhgR1.w);AH2 gG=AH2(klhgG0.w,klhgG1.w);AH2 gB=AH2(klhgB0.w,klhgB1.w);
+  AH2 oR=AH2(zzonR0.z,zzonR1.z);AH2 oG=AH2(zzonG0.z,zzonG1.z);AH2 oB=AH2(zzonB0.z,zzonB1.z);
+  AH2 nR=AH2(zzonR0.w,zzonR1.w);AH2 nG=AH2(zzonG0.w,zzonG1.w);AH2 nB=AH2(zzonB0.w,zzonB1.w);
+//------------------------------------------------------------------------------------------------------------------------------
+  // Simplest multi-channel approximate luma possible (luma times 2, in 2 FMA/MAD).
+  AH2 bL=bB*AH2_(0.5)+(bR*AH2_(0.5)+bG);
+  AH2 cL=cB*AH2_(0.5)+(cR*AH2_(0.5)+cG);
+  AH2 iL=iB*AH2_(0.5)+(iR*AH2_(0.5)+iG);
+  AH2 jL=jB*AH2_(0.5)+(jR*AH2_(0.5)+jG);
+  AH2 fL=fB*AH2_(0.5)+(fR*AH2_(0.5)+fG);
+  AH2 eL=eB*AH2_(0.5)+(eR*AH2_(0.5)+eG);
+  AH2 kL=kB*AH2_(0.5)+(kR*AH2_(0.5)+kG);
+  AH2 lL=lB*AH2_(0.5)+(lR*AH2_(0.5)+lG);
+  AH2 hL=hB*AH2_(0.5)+(hR*AH2_(0.5)+hG);
+  AH2 gL=gB*AH2_(0.5)+(gR*AH2_(0.5)+gG);
+  AH2 oL=oB*AH2_(0.5)+(oR*AH2_(0.5)+oG);
+  AH2 nL=nB*AH2_(0.5)+(nR*AH2_(0.5)+nG);
+  // Accumulate for bilinear interpolation, all four quadrants since the lanes are taken by the two pixels.
+  //  s t
+  //  u v
+  AH2 dirX=AH2_(0.0);
+  AH2 dirY=AH2_(0.0);
+  AH2 len=AH2_(0.0);
+  AH2 ppXn=AH2_(1.0)-ppX;
+  AH2 ppYn=AH2_(1.0)-ppY;
+  FsrEasuSetHx2(dirX,dirY,len,ppXn*ppYn,bL,eL,fL,gL,jL);
+  FsrEasuSetHx2(dirX,dirY,len,ppX *ppYn,cL,fL,gL,hL,kL);
+  FsrEasuSetHx2(dirX,dirY,len,ppXn*ppY ,fL,iL,jL,kL,nL);
+  FsrEasuSetHx2(dirX,dirY,len,ppX *ppY ,gL,jL,kL,lL,oL);
+//------------------------------------------------------------------------------------------------------------------------------
+  // Normalize with approximation, and cleanup close to zero.
+  // Selects use zero-one logic since there is no portable packed boolean select.
+  AH2 dirR=dirX*dirX+dirY*dirY;
+  AH2 zro=AZolSignedH2(dirR-AH2_(1.0/32768.0));
+  dirR=APrxLoRsqH2(dirR);
+  dirR=AZolSelH2(zro,AH2_(1.0),dirR);
+  dirX=AZolSelH2(zro,AH2_(1.0),dirX);
+  dirX*=dirR;
+  dirY*=dirR;
+  // Transform from {0 to 2} to {0 to 1} range, and shape with square.
+  len=len*AH2_(0.5);
+  len*=len;
+  // Stretch kernel {1.0 vert|horz, to sqrt(2.0) on diagonal}.
+  AH2 stretch=(dirX*dirX+dirY*dirY)*APrxLoRcpH2(max(abs(dirX),abs(dirY)));
+  // Anisotropic length after rotation,
+  //  x := 1.0 lerp to 'stretch' on edges
+  //  y := 1.0 lerp to 2x on edges
+  AH2 len2X=AH2_(1.0)+(stretch-AH2_(1.0))*len;
+  AH2 len2Y=AH2_(1.0)+AH2_(-0.5)*len;
+  // Based on the amount of 'edge',
+  // the window shifts from +/-{sqrt(2.0) to slightly beyond 2.0}.
+  AH2 lob=AH2_(0.5)+AH2_((1.0/4.0-0.04)-0.5)*len;
+  // Set distance^2 clipping point to the end of the adjustable window.
+  AH2 clp=APrxLoRcpH2(lob);
+//------------------------------------------------------------------------------------------------------------------------------
+  // Min and max of ring.
+  AH2 min4R=min(min(fR,gR),min(jR,kR));
+  AH2 min4G=min(min(fG,gG),min(jG,kG));
+  AH2 min4B=min(min(fB,gB),min(jB,kB));
+  AH2 max4R=max(max(fR,gR),max(jR,kR));
+  AH2 max4G=max(max(fG,gG),max(jG,kG));
+  AH2 max4B=max(max(fB,gB),max(jB,kB));
+  // Accumulation.
+  AH2 aCR=AH2_(0.0);
+  AH2 aCG=AH2_(0.0);
+  AH2 aCB=AH2_(0.0);
+  AH2 aW=AH2_(0.0);
+  FsrEasuTapHx2(aCR,aCG,aCB,aW,AH2_( 0.0)-ppX,AH2_(-1.0)-ppY,dirX,dirY,len2X,len2Y,lob,clp,bR,bG,bB); // b
+  FsrEasuTapHx2(aCR,aCG,aCB,aW,AH2_( 1.0)-ppX,AH2_(-1.0)-ppY,dirX,dirY,len2X,len2Y,lob,clp,cR,cG,cB); // c
+  FsrEasuTapHx2(aCR,aCG,aCB,aW,AH2_(-1.0)-ppX,AH2_( 1.0)-ppY,dirX,dirY,len2X,len2Y,lob,clp,iR,iG,iB); // i
+  FsrEasuTapHx2(aCR,aCG,aCB,aW,AH2_( 0.0)-ppX,AH2_( 1.0)-ppY,dirX,dirY,len2X,len2Y,lob,clp,jR,jG,jB); // j
+  FsrEasuTapHx2(aCR,aCG,aCB,aW,AH2_( 0.0)-ppX,AH2_( 0.0)-ppY,dirX,dirY,len2X,len2Y,lob,clp,fR,fG,fB); // f
+  FsrEasuTapHx2(aCR,aCG,aCB,aW,AH2_(-1.0)-ppX,AH2_( 0.0)-ppY,dirX,dirY,len2X,len2Y,lob,clp,eR,eG,eB); // e
+  FsrEasuTapHx2(aCR,aCG,aCB,aW,AH2_( 1.0)-ppX,AH2_( 1.0)-ppY,dirX,dirY,len2X,len2Y,lob,clp,kR,kG,kB); // k
+  FsrEasuTapHx2(aCR,aCG,aCB,aW,AH2_( 2.0)-ppX,AH2_( 1.0)-ppY,dirX,dirY,len2X,len2Y,lob,clp,lR,lG,lB); // l
+  FsrEasuTapHx2(aCR,aCG,aCB,aW,AH2_( 2.0)-ppX,AH2_( 0.0)-ppY,dirX,dirY,len2X,len2Y,lob,clp,hR,hG,hB); // h
+  FsrEasuTapHx2(aCR,aCG,aCB,aW,AH2_( 1.0)-ppX,AH2_( 0.0)-ppY,dirX,dirY,len2X,len2Y,lob,clp,gR,gG,gB); // g
+  FsrEasuTapHx2(aCR,aCG,aCB,aW,AH2_( 1.0)-ppX,AH2_( 2.0)-ppY,dirX,dirY,len2X,len2Y,lob,clp,oR,oG,oB); // o
+  FsrEasuTapHx2(aCR,aCG,aCB,aW,AH2_( 0.0)-ppX,AH2_( 2.0)-ppY,dirX,dirY,len2X,len2Y,lob,clp,nR,nG,nB); // n
+//------------------------------------------------------------------------------------------------------------------------------
+  // Normalize and dering.
+  AH2 rW=ARcpH2(aW);
+  pixR=min(max4R,max(min4R,aCR*rW));
+  pixG=min(max4G,max(min4G,aCG*rW));
+  pixB=min(max4B,max(min4B,aCB*rW));}
+#endif
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //_____________________________________________________________/\_______________________________________________________________
@@ -670,6 +927,19 @@ AF1 sharpness){
  con[1]=AU1_AH2_AF2(hSharp);
  con[2]=0;
  con[3]=0;}
+//------------------------------------------------------------------------------------------------------------------------------
+// Compile time version for C++14 and later, see 'FsrEasuConCt()'.
+#ifdef A_CONSTEXPR
+ struct FsrRcasConstants{AU1 con[4];};
+ A_CONSTEXPR FsrRcasConstants FsrRcasConCt(AF1 sharpness){
+  FsrRcasConstants c={};
+  sharpness=AExp2F1Ct(-sharpness);
+  c.con[0]=AU1_AF1Ct(sharpness);
+  c.con[1]=AU1_AH2_AF2Ct(sharpness,sharpness);
+  c.con[2]=0;
+  c.con[3]=0;
+  return c;}
+#endif
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //_____________________________________________________________/\_______________________________________________________________
@@ -1008,6 +1278,38 @@ AF1 sharpness){
 //    amount); // Amount of grain (0 to 1} ranged.
 //------------------------------------------------------------------------------------------------------------------------------
 // Example if grain texture is monochrome: 'FsrLfgaF(color,AF3_(grain),amount)'
+//------------------------------------------------------------------------------------------------------------------------------
+// CPU usage,
+// Grain is cheap per pixel, so running it as a separate pass over the output is mostly bandwidth overhead.
+// Instead call 'FsrLfgaRowF()' from inside the store loop of the last output-resolution pass (for example RCAS),
+// while the row is still in cache.
+// The noise input is laid out like the sample's tiled blue noise texture: 128 pixels wide, 8 slices of 128 stacked in Y.
+// Pass the same 'frame' index {0 to 7} as the tonemapper so grain and dither advance together.
+//   FsrLfgaRowF(
+//    row,    // Row of 'count' interleaved linear RGB pixels {0 to 1} ranged, modified in place.
+//    count,  // Number of pixels in the row.
+//    x,y,    // Output pixel position of the first pixel in the row.
+//    frame,  // Temporal slice of the noise {0 to 7}.
+//    noise,  // Single channel blue noise {0 to 1} ranged, 128x1024 floats.
+//    amount); // Amount of grain (0 to 1} ranged.
+//==============================================================================================================================
+#if defined(A_CPU)
+ A_STATIC void FsrLfgaF(inoutAF3 c,inAF3 t,AF1 a){
+  c[0]+=(t[0]*a)*AMinF1(AF1_(1.0)-c[0],c[0]);
+  c[1]+=(t[1]*a)*AMinF1(AF1_(1.0)-c[1],c[1]);
+  c[2]+=(t[2]*a)*AMinF1(AF1_(1.0)-c[2],c[2]);}
+//------------------------------------------------------------------------------------------------------------------------------
+ // Monochrome grain for a row, noise is re-centered from {0 to 1} to {-0.5 to 0.5}.
+ // The row of the noise slice is fixed for the whole call, so the inner loop only wraps 'x'.
+ A_STATIC void FsrLfgaRowF(AF1*A_RESTRICT row,AU1 count,AU1 x,AU1 y,AU1 frame,const AF1*A_RESTRICT noise,AF1 a){
+  const AF1*A_RESTRICT t=noise+((y&AU1_(127))+(frame&AU1_(7))*AU1_(128))*AU1_(128);
+  for(AU1 i=0;i<count;i++){
+   AF1 g=(t[(x+i)&AU1_(127)]-AF1_(0.5))*a;
+   AF1*A_RESTRICT c=row+i*AU1_(3);
+   c[0]+=g*AMinF1(AF1_(1.0)-c[0],c[0]);
+   c[1]+=g*AMinF1(AF1_(1.0)-c[1],c[1]);
+   c[2]+=g*AMinF1(AF1_(1.0)-c[2],c[2]);}}
+#endif
 //==============================================================================================================================
 #if defined(A_GPU)
  // Maximum grain is the minimum distance to the signal limit.
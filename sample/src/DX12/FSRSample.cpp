@@ -605,9 +605,25 @@ void FSRSample::BuildUI()
                 m_state.mipBias = mipBias[4];
             if (m_state.m_nUpscaleType == 1)
             {
+                if (m_Node->IsEasuHx2Available())
+                    ImGui::Checkbox("Packed EASU (Hx2)", &m_state.bUseEasuHx2);
                 ImGui::Checkbox("FSR 1.0 Sharpening", &m_state.bUseRcas);
                 if( m_state.bUseRcas )
+                {
                     ImGui::SliderFloat("Sharpening attenuation", &m_state.rcasAttenuation, 0.0f, 2.0f);
+                    ImGui::Checkbox("Fused EASU + RCAS", &m_state.bUseFusedRcas);
+                    if (!m_state.bUseFusedRcas)
+                    {
+                        ImGui::Checkbox("Packed RCAS (Hx2)", &m_state.bUseRcasHx2);
+                        if (m_state.bUseRcasHx2)
+                        {
+                            ImGui::Checkbox("Temporal dither (TEPD)", &m_state.bUseTepd);
+                            ImGui::Checkbox("Film grain (LFGA)", &m_state.bUseLfga);
+                            if (m_state.bUseLfga)
+                                ImGui::SliderFloat("Grain amount", &m_state.lfgaAmount, 0.0f, 1.0f);
+                        }
+                    }
+                }
             }
             if (m_state.m_nUpscaleType)
             {
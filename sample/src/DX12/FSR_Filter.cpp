@@ -26,20 +26,9 @@
 #include "ffx_a.h"
 #include "ffx_fsr1.h"
 
-#include <DirectXMath.h>
-using namespace DirectX;
-
-struct FSRConstants
-{
-	XMUINT4 Const0;
-	XMUINT4 Const1;
-	XMUINT4 Const2;
-	XMUINT4 Const3;
-	XMUINT4 Sample;
-};
-
 void FSR_Filter::OnCreate(Device* pDevice, ResourceViewHeaps* pResourceViewHeaps, bool slowFallback)
 {
+	m_pResourceViewHeaps = pResourceViewHeaps;
 	pResourceViewHeaps->AllocCBV_SRV_UAVDescriptor(1, &m_outputTextureUav);
 	pResourceViewHeaps->AllocCBV_SRV_UAVDescriptor(1, &m_inputTextureSrv);
 	pResourceViewHeaps->AllocCBV_SRV_UAVDescriptor(1, &m_intermediarySrv);
@@ -52,19 +41,91 @@ void FSR_Filter::OnCreate(Device* pDevice, ResourceViewHeaps* pResourceViewHeaps
 	sd.MaxAnisotropy = 1;
 	sd.MaxLOD = D3D12_FLOAT32_MAX;
 
+	// Same layout as PostProcCS, except that b0 is made of root constants instead of a root CBV.
+	{
+		CD3DX12_DESCRIPTOR_RANGE DescRange[2];
+		DescRange[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 0);
+		DescRange[1].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0);
+
+		CD3DX12_ROOT_PARAMETER RTSlot[3];
+		RTSlot[0].InitAsConstants(sizeof(FSRConstants) / sizeof(uint32_t), 0, 0, D3D12_SHADER_VISIBILITY_ALL);
+		RTSlot[1].InitAsDescriptorTable(1, &DescRange[0], D3D12_SHADER_VISIBILITY_ALL);
+		RTSlot[2].InitAsDescriptorTable(1, &DescRange[1], D3D12_SHADER_VISIBILITY_ALL);
+
+		CD3DX12_ROOT_SIGNATURE_DESC descRootSignature = CD3DX12_ROOT_SIGNATURE_DESC();
+		descRootSignature.NumParameters = _countof(RTSlot);
+		descRootSignature.pParameters = RTSlot;
+		descRootSignature.NumStaticSamplers = 1;
+		descRootSignature.pStaticSamplers = &sd;
+		descRootSignature.Flags = D3D12_ROOT_SIGNATURE_FLAG_NONE;
+
+		ID3DBlob *pOutBlob, *pErrorBlob = NULL;
+		ThrowIfFailed(D3D12SerializeRootSignature(&descRootSignature, D3D_ROOT_SIGNATURE_VERSION_1, &pOutBlob, &pErrorBlob));
+		ThrowIfFailed(pDevice->GetDevice()->CreateRootSignature(0, pOutBlob->GetBufferPointer(), pOutBlob->GetBufferSize(), IID_PPV_ARGS(&m_pRootSignature)));
+		SetName(m_pRootSignature, "FSR_Filter");
+		pOutBlob->Release();
+		if (pErrorBlob)
+			pErrorBlob->Release();
+	}
+
 	DefineList defines;
 	defines["SAMPLE_SLOW_FALLBACK"] = (slowFallback ? "1" : "0");
 	defines["SAMPLE_BILINEAR"] = "0";
 	defines["SAMPLE_RCAS"] = "0";
+	defines["SAMPLE_FUSED"] = "0";
+	defines["SAMPLE_RCAS_HX2"] = "0";
+	defines["SAMPLE_EASU_HX2"] = "0";
+	defines["SAMPLE_TEPD"] = "0";
+	defines["SAMPLE_LFGA"] = "0";
 	defines["SAMPLE_EASU"] = "1";
-	m_easu.OnCreate(pDevice, pResourceViewHeaps, "FSR_Pass.hlsl", "mainCS", 1, 1, 64, 1, 1, &defines, 1, &sd);
+	CreatePipeline(pDevice, &defines, &m_easu);
 	defines["SAMPLE_EASU"] = "0";
 	defines["SAMPLE_RCAS"] = "1";
-	m_rcas.OnCreate(pDevice, pResourceViewHeaps, "FSR_Pass.hlsl", "mainCS", 1, 1, 64, 1, 1, &defines, 1, &sd);
+	CreatePipeline(pDevice, &defines, &m_rcas);
 	defines["SAMPLE_RCAS"] = "0";
 	defines["SAMPLE_BILINEAR"] = "1";
-	m_bilinear.OnCreate(pDevice, pResourceViewHeaps, "FSR_Pass.hlsl", "mainCS", 1, 1, 64, 1, 1, &defines, 1, &sd);
+	CreatePipeline(pDevice, &defines, &m_bilinear);
 	defines["SAMPLE_BILINEAR"] = "0";
+	defines["SAMPLE_FUSED"] = "1";
+	CreatePipeline(pDevice, &defines, &m_fused);
+	defines["SAMPLE_FUSED"] = "0";
+	// The packed passes need fp16. The packed EASU is an EASU permutation, it stays opt-in until it is validated against FsrEasuH.
+	if (!slowFallback)
+	{
+		defines["SAMPLE_EASU"] = "1";
+		defines["SAMPLE_EASU_HX2"] = "1";
+		CreatePipeline(pDevice, &defines, &m_easuHx2);
+		defines["SAMPLE_EASU"] = "0";
+		defines["SAMPLE_EASU_HX2"] = "0";
+		defines["SAMPLE_RCAS_HX2"] = "1";
+		for (int post = 0; post < FSR_POST_COUNT; post++)
+		{
+			defines["SAMPLE_TEPD"] = (post & FSR_POST_TEPD) ? "1" : "0";
+			defines["SAMPLE_LFGA"] = (post & FSR_POST_LFGA) ? "1" : "0";
+			CreatePipeline(pDevice, &defines, &m_rcasHx2[post]);
+		}
+	}
+
+	m_constsValid = false;
+}
+
+void FSR_Filter::CreatePipeline(Device* pDevice, DefineList* pDefines, ID3D12PipelineState** ppPipeline)
+{
+	DefineList defines = *pDefines;
+	defines["WIDTH"] = "64";
+	defines["HEIGHT"] = "1";
+	defines["DEPTH"] = "1";
+
+	D3D12_SHADER_BYTECODE shaderByteCode = {};
+	CompileShaderFromFile("FSR_Pass.hlsl", &defines, "mainCS", "-T cs_6_0", &shaderByteCode);
+
+	D3D12_COMPUTE_PIPELINE_STATE_DESC descPso = {};
+	descPso.CS = shaderByteCode;
+	descPso.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
+	descPso.pRootSignature = m_pRootSignature;
+	descPso.NodeMask = 0;
+	ThrowIfFailed(pDevice->GetDevice()->CreateComputePipelineState(&descPso, IID_PPV_ARGS(ppPipeline)));
+	SetName(*ppPipeline, "FSR_Filter");
 }
 
 void FSR_Filter::OnCreateWindowSizeDependentResources(Device* pDevice, ID3D12Resource* input, ID3D12Resource* output, int displayWidth, int displayHeight, State* pState, bool hdr)
@@ -93,50 +154,118 @@ void FSR_Filter::OnDestroyWindowSizeDependentResources()
 
 void FSR_Filter::OnDestroy()
 {
-	m_easu.OnDestroy();
-	m_rcas.OnDestroy();
-	m_bilinear.OnDestroy();
+	m_easu->Release();
+	m_rcas->Release();
+	m_bilinear->Release();
+	m_fused->Release();
+	if (m_easuHx2)
+		m_easuHx2->Release();
+	m_easuHx2 = 0;
+	for (int post = 0; post < FSR_POST_COUNT; post++)
+	{
+		if (m_rcasHx2[post])
+			m_rcasHx2[post]->Release();
+		m_rcasHx2[post] = 0;
+	}
+	m_pRootSignature->Release();
 }
 
-void FSR_Filter::Upscale(ID3D12GraphicsCommandList* pCommandList, int displayWidth, int displayHeight, State* pState, DynamicBufferRing* pConstantBufferRing, bool hdr)
+// The constants only depend on the resolutions, the sharpness and the output mode, so they are rebuilt only when one of those changes.
+void FSR_Filter::UpdateConstants(int displayWidth, int displayHeight, State* pState, bool hdr)
 {
-	D3D12_GPU_VIRTUAL_ADDRESS cbHandle = {};
-	{
-		FSRConstants consts = {};
-		FsrEasuCon(reinterpret_cast<AU1*>(&consts.Const0), reinterpret_cast<AU1*>(&consts.Const1), reinterpret_cast<AU1*>(&consts.Const2), reinterpret_cast<AU1*>(&consts.Const3), static_cast<AF1>(pState->renderWidth), static_cast<AF1>(pState->renderHeight), static_cast<AF1>(pState->renderWidth), static_cast<AF1>(pState->renderHeight), (AF1)displayWidth, (AF1)displayHeight);
-		consts.Sample.x = (hdr && !pState->bUseRcas) ? 1 : 0;
-		uint32_t* pConstMem = 0;
-		pConstantBufferRing->AllocConstantBuffer(sizeof(FSRConstants), (void**)&pConstMem, &cbHandle);
-		memcpy(pConstMem, &consts, sizeof(FSRConstants));
-	}
+	bool useRcas = pState->bUseRcas;
+	if (m_constsValid &&
+		m_constsRenderWidth == pState->renderWidth && m_constsRenderHeight == pState->renderHeight &&
+		m_constsDisplayWidth == displayWidth && m_constsDisplayHeight == displayHeight &&
+		m_constsSharpness == pState->rcasAttenuation && m_constsUseRcas == useRcas && m_constsHdr == hdr)
+		return;
+
+	m_easuConsts = {};
+	FsrEasuCon(reinterpret_cast<AU1*>(&m_easuConsts.Const0), reinterpret_cast<AU1*>(&m_easuConsts.Const1), reinterpret_cast<AU1*>(&m_easuConsts.Const2), reinterpret_cast<AU1*>(&m_easuConsts.Const3), static_cast<AF1>(pState->renderWidth), static_cast<AF1>(pState->renderHeight), static_cast<AF1>(pState->renderWidth), static_cast<AF1>(pState->renderHeight), (AF1)displayWidth, (AF1)displayHeight);
+	m_easuConsts.Sample.x = (hdr && !useRcas) ? 1 : 0;
+
+	m_rcasConsts = {};
+	FsrRcasCon(reinterpret_cast<AU1*>(&m_rcasConsts.Const0), pState->rcasAttenuation);
+	m_rcasConsts.Sample.x = (hdr ? 1 : 0);
+
+	// The fused pass needs both, plus the output size to clamp its halo.
+	m_fusedConsts = m_easuConsts;
+	m_fusedConsts.Sample.x = (hdr ? 1 : 0);
+	m_fusedConsts.Const4 = m_rcasConsts.Const0;
+	m_fusedConsts.Const4.z = displayWidth;
+	m_fusedConsts.Const4.w = displayHeight;
+
+	m_constsValid = true;
+	m_constsRenderWidth = pState->renderWidth;
+	m_constsRenderHeight = pState->renderHeight;
+	m_constsDisplayWidth = displayWidth;
+	m_constsDisplayHeight = displayHeight;
+	m_constsSharpness = pState->rcasAttenuation;
+	m_constsUseRcas = useRcas;
+	m_constsHdr = hdr;
+}
+
+void FSR_Filter::Dispatch(ID3D12GraphicsCommandList* pCommandList, ID3D12PipelineState* pPipeline, CBV_SRV_UAV* pUAV, CBV_SRV_UAV* pSRV, const FSRConstants* pConsts, int dispatchX, int dispatchY)
+{
+	ID3D12DescriptorHeap* pDescriptorHeaps[] = { m_pResourceViewHeaps->GetCBV_SRV_UAVHeap(), m_pResourceViewHeaps->GetSamplerHeap() };
+	pCommandList->SetDescriptorHeaps(2, pDescriptorHeaps);
+	pCommandList->SetComputeRootSignature(m_pRootSignature);
+	pCommandList->SetComputeRoot32BitConstants(0, sizeof(FSRConstants) / sizeof(uint32_t), pConsts, 0);
+	pCommandList->SetComputeRootDescriptorTable(1, pUAV->GetGPU());
+	pCommandList->SetComputeRootDescriptorTable(2, pSRV->GetGPU());
+	pCommandList->SetPipelineState(pPipeline);
+	pCommandList->Dispatch(dispatchX, dispatchY, 1);
+}
+
+void FSR_Filter::Upscale(ID3D12GraphicsCommandList* pCommandList, int displayWidth, int displayHeight, State* pState, bool hdr, GPUTimestamps* pTimer)
+{
+	UpdateConstants(displayWidth, displayHeight, pState, hdr);
+	m_frameIndex++;
 	// This value is the image region dimension that each thread group of the FSR shader operates on
 	static const int threadGroupWorkRegionDim = 16;
 	int dispatchX = (displayWidth + (threadGroupWorkRegionDim - 1)) / threadGroupWorkRegionDim;
 	int dispatchY = (displayHeight + (threadGroupWorkRegionDim - 1)) / threadGroupWorkRegionDim;
+	ID3D12PipelineState* pEasu = (pState->bUseEasuHx2 && m_easuHx2) ? m_easuHx2 : m_easu;
 	if (pState->m_nUpscaleType)
 	{
 		UserMarker marker(pCommandList, "FSR upscaling");
-		if (pState->bUseRcas)
+		if (pState->bUseRcas && pState->bUseFusedRcas)
 		{
-			m_easu.Draw(pCommandList, cbHandle, &m_intermediaryUav, &m_inputTextureSrv, dispatchX, dispatchY, 1);
+			// EASU goes to groupshared memory and RCAS reads it from there, no intermediary and no barrier.
+			Dispatch(pCommandList, m_fused, &m_outputTextureUav, &m_inputTextureSrv, &m_fusedConsts, dispatchX, dispatchY);
+			pTimer->GetTimeStamp(pCommandList, "FSR EASU + RCAS fused");
+		}
+		else if (pState->bUseRcas)
+		{
+			Dispatch(pCommandList, pEasu, &m_intermediaryUav, &m_inputTextureSrv, &m_easuConsts, dispatchX, dispatchY);
+			pTimer->GetTimeStamp(pCommandList, "FSR EASU");
+			pCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_intermediary.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE));
+			if (pState->bUseRcasHx2 && m_rcasHx2[0])
 			{
-				FSRConstants consts = {};
-				FsrRcasCon(reinterpret_cast<AU1*>(&consts.Const0), pState->rcasAttenuation);
-				consts.Sample.x = (hdr ? 1 : 0);
-				uint32_t* pConstMem = 0;
-				pConstantBufferRing->AllocConstantBuffer(sizeof(FSRConstants), (void**)&pConstMem, &cbHandle);
-				memcpy(pConstMem, &consts, sizeof(FSRConstants));
+				// Dither only makes sense for the 8-bit SDR output, HDR stores linear FP16.
+				uint32_t post = ((pState->bUseTepd && !hdr) ? FSR_POST_TEPD : 0) | (pState->bUseLfga ? FSR_POST_LFGA : 0);
+				m_rcasConsts.Sample.y = m_frameIndex;
+				m_rcasConsts.Sample.z = AU1_AF1(pState->lfgaAmount);
+				Dispatch(pCommandList, m_rcasHx2[post], &m_outputTextureUav, &m_intermediarySrv, &m_rcasConsts, dispatchX, dispatchY);
+				pTimer->GetTimeStamp(pCommandList, "FSR RCAS Hx2");
+			}
+			else
+			{
+				Dispatch(pCommandList, m_rcas, &m_outputTextureUav, &m_intermediarySrv, &m_rcasConsts, dispatchX, dispatchY);
+				pTimer->GetTimeStamp(pCommandList, "FSR RCAS");
 			}
-			pCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_intermediary.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE));
-			m_rcas.Draw(pCommandList, cbHandle, &m_outputTextureUav, &m_intermediarySrv, dispatchX, dispatchY, 1);
 			pCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_intermediary.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS));
 		}
 		else
-			m_easu.Draw(pCommandList, cbHandle, &m_outputTextureUav, &m_inputTextureSrv, dispatchX, dispatchY, 1);
+		{
+			Dispatch(pCommandList, pEasu, &m_outputTextureUav, &m_inputTextureSrv, &m_easuConsts, dispatchX, dispatchY);
+			pTimer->GetTimeStamp(pCommandList, "FSR 1.0");
+		}
 	} else
 	{
 		UserMarker marker(pCommandList, "Bilinear upscaling");
-		m_bilinear.Draw(pCommandList, cbHandle, &m_outputTextureUav, &m_inputTextureSrv, dispatchX, dispatchY, 1);
+		Dispatch(pCommandList, m_bilinear, &m_outputTextureUav, &m_inputTextureSrv, &m_easuConsts, dispatchX, dispatchY);
+		pTimer->GetTimeStamp(pCommandList, "Upscaling");
 	}
 }
 
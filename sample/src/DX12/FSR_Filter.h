@@ -18,12 +18,23 @@
 // THE SOFTWARE.
 
 #pragma once
-#include "PostProc/PostProcCS.h"
+#include <DirectXMath.h>
 
 using namespace CAULDRON_DX12;
 
 struct State;
 
+// Sent to the FSR passes as root constants, see FSR_Pass.hlsl.
+struct FSRConstants
+{
+	DirectX::XMUINT4 Const0;
+	DirectX::XMUINT4 Const1;
+	DirectX::XMUINT4 Const2;
+	DirectX::XMUINT4 Const3;
+	DirectX::XMUINT4 Sample;
+	DirectX::XMUINT4 Const4;
+};
+
 class FSR_Filter
 {
 public:
@@ -31,15 +42,48 @@ public:
 	void OnCreateWindowSizeDependentResources(Device* pDevice, ID3D12Resource* input, ID3D12Resource* output, int displayWidth, int displayHeight, State* pState, bool hdr);
 	void OnDestroyWindowSizeDependentResources();
 	void OnDestroy();
-	void Upscale(ID3D12GraphicsCommandList* pCommandList, int displayWidth, int displayHeight, State *pState, DynamicBufferRing* pConstantBufferRing, bool hdr);
+	// Timestamps are taken per pass so the RCAS variants can be told apart in the profiler.
+	void Upscale(ID3D12GraphicsCommandList* pCommandList, int displayWidth, int displayHeight, State *pState, bool hdr, GPUTimestamps* pTimer);
+	// The packed EASU is only built without the slow fallback, State::bUseEasuHx2 is ignored without it.
+	bool IsEasuHx2Available() const { return m_easuHx2 != 0; }
 
 private:
-	PostProcCS                      m_easu;
-	PostProcCS                      m_rcas;
-	PostProcCS                      m_bilinear;
+	// Stages fused into the store of the packed RCAS pass, the SAMPLE_TEPD and SAMPLE_LFGA permutations.
+	enum FSRPost
+	{
+		FSR_POST_TEPD = 1,
+		FSR_POST_LFGA = 2,
+		FSR_POST_COUNT = 4
+	};
+	void CreatePipeline(Device* pDevice, DefineList* pDefines, ID3D12PipelineState** ppPipeline);
+	void UpdateConstants(int displayWidth, int displayHeight, State* pState, bool hdr);
+	void Dispatch(ID3D12GraphicsCommandList* pCommandList, ID3D12PipelineState* pPipeline, CBV_SRV_UAV* pUAV, CBV_SRV_UAV* pSRV, const FSRConstants* pConsts, int dispatchX, int dispatchY);
+
+	ResourceViewHeaps               *m_pResourceViewHeaps = 0;
+	ID3D12RootSignature             *m_pRootSignature = 0;
+	ID3D12PipelineState             *m_easu = 0;
+	ID3D12PipelineState             *m_rcas = 0;
+	ID3D12PipelineState             *m_bilinear = 0;
+	ID3D12PipelineState             *m_fused = 0;
+	ID3D12PipelineState             *m_easuHx2 = 0; // fp16 only
+	ID3D12PipelineState             *m_rcasHx2[FSR_POST_COUNT] = {}; // fp16 only
+	uint32_t                        m_frameIndex = 0;
 	CBV_SRV_UAV                     m_outputTextureUav;
 	CBV_SRV_UAV                     m_inputTextureSrv;
 	Texture							m_intermediary;
 	CBV_SRV_UAV                     m_intermediaryUav;
 	CBV_SRV_UAV                     m_intermediarySrv;
+
+	// Constants of the last Upscale() and what they were built from.
+	FSRConstants                    m_easuConsts = {};
+	FSRConstants                    m_rcasConsts = {};
+	FSRConstants                    m_fusedConsts = {};
+	bool                            m_constsValid = false;
+	uint32_t                        m_constsRenderWidth = 0;
+	uint32_t                        m_constsRenderHeight = 0;
+	int                             m_constsDisplayWidth = 0;
+	int                             m_constsDisplayHeight = 0;
+	float                           m_constsSharpness = 0.0f;
+	bool                            m_constsUseRcas = false;
+	bool                            m_constsHdr = false;
 };
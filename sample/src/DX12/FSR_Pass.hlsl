@@ -16,6 +16,7 @@
 // LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 // THE SOFTWARE.
+// Bound as root constants by FSR_Filter.
 cbuffer cb : register(b0)
 {
 	uint4 Const0;
@@ -23,6 +24,7 @@ cbuffer cb : register(b0)
 	uint4 Const2;
 	uint4 Const3;
 	uint4 Sample;
+	uint4 Const4; // SAMPLE_FUSED only: RCAS constants in xy, output size in zw.
 };
 
 #define A_GPU 1
@@ -32,39 +34,99 @@ SamplerState		samLinearClamp : register(s0);
 
 #if SAMPLE_SLOW_FALLBACK
 	#include "ffx_a.h"
+#else
+	#define A_HALF
+	#include "ffx_a.h"
+#endif
+
+#if SAMPLE_FUSED
+	// EASU output of the workgroup's 16x16 region plus a 1 pixel halo, RCAS reads its taps from here.
+	#define FUSED_TILE_DIM 18u
+	groupshared AF1 FusedTileR[FUSED_TILE_DIM * FUSED_TILE_DIM];
+	groupshared AF1 FusedTileG[FUSED_TILE_DIM * FUSED_TILE_DIM];
+	groupshared AF1 FusedTileB[FUSED_TILE_DIM * FUSED_TILE_DIM];
+	static ASU2 FusedTileOrigin;
+	AF3 FusedTileLoad(ASU2 p)
+	{
+		AU1 i = AU1(p.x - FusedTileOrigin.x) + AU1(p.y - FusedTileOrigin.y) * FUSED_TILE_DIM;
+		return AF3(FusedTileR[i], FusedTileG[i], FusedTileB[i]);
+	}
+#endif
+
+#if SAMPLE_SLOW_FALLBACK
 	Texture2D InputTexture : register(t0);
 	RWTexture2D<float4> OutputTexture : register(u0);
-	#if SAMPLE_EASU
+	#if SAMPLE_EASU || SAMPLE_FUSED
 		#define FSR_EASU_F 1
 		AF4 FsrEasuRF(AF2 p) { AF4 res = InputTexture.GatherRed(samLinearClamp, p, int2(0, 0)); return res; }
 		AF4 FsrEasuGF(AF2 p) { AF4 res = InputTexture.GatherGreen(samLinearClamp, p, int2(0, 0)); return res; }
 		AF4 FsrEasuBF(AF2 p) { AF4 res = InputTexture.GatherBlue(samLinearClamp, p, int2(0, 0)); return res; }
 	#endif
-	#if SAMPLE_RCAS
+	#if SAMPLE_RCAS || SAMPLE_FUSED
 		#define FSR_RCAS_F
-		AF4 FsrRcasLoadF(ASU2 p) { return InputTexture.Load(int3(ASU2(p), 0)); }
+		#if SAMPLE_FUSED
+			AF4 FsrRcasLoadF(ASU2 p) { return AF4(FusedTileLoad(p), 1); }
+		#else
+			AF4 FsrRcasLoadF(ASU2 p) { return InputTexture.Load(int3(ASU2(p), 0)); }
+		#endif
 		void FsrRcasInputF(inout AF1 r, inout AF1 g, inout AF1 b) {}
 	#endif
 #else
-	#define A_HALF
-	#include "ffx_a.h"
 	Texture2D<AH4> InputTexture : register(t0);
 	RWTexture2D<AH4> OutputTexture : register(u0);
-	#if SAMPLE_EASU
+	#if SAMPLE_EASU || SAMPLE_FUSED
 		#define FSR_EASU_H 1
 		AH4 FsrEasuRH(AF2 p) { AH4 res = InputTexture.GatherRed(samLinearClamp, p, int2(0, 0)); return res; }
 		AH4 FsrEasuGH(AF2 p) { AH4 res = InputTexture.GatherGreen(samLinearClamp, p, int2(0, 0)); return res; }
 		AH4 FsrEasuBH(AF2 p) { AH4 res = InputTexture.GatherBlue(samLinearClamp, p, int2(0, 0)); return res; }	
 	#endif
-	#if SAMPLE_RCAS
+	#if SAMPLE_EASU_HX2
+		#define FSR_EASU_HX2 1
+		AH4 FsrEasuRHx2(AF2 p) { return FsrEasuRH(p); }
+		AH4 FsrEasuGHx2(AF2 p) { return FsrEasuGH(p); }
+		AH4 FsrEasuBHx2(AF2 p) { return FsrEasuBH(p); }
+	#endif
+	#if SAMPLE_RCAS_HX2
+		#define FSR_RCAS_HX2 1
+		AH4 FsrRcasLoadHx2(ASW2 p) { return InputTexture.Load(ASW3(p, 0)); }
+		void FsrRcasInputHx2(inout AH2 r,inout AH2 g,inout AH2 b){}
+	#endif
+	#if SAMPLE_RCAS || SAMPLE_FUSED
 		#define FSR_RCAS_H
-		AH4 FsrRcasLoadH(ASW2 p) { return InputTexture.Load(ASW3(ASW2(p), 0)); }
+		#if SAMPLE_FUSED
+			AH4 FsrRcasLoadH(ASW2 p) { return AH4(FusedTileLoad(ASU2(p)), 1); }
+		#else
+			AH4 FsrRcasLoadH(ASW2 p) { return InputTexture.Load(ASW3(ASW2(p), 0)); }
+		#endif
 		void FsrRcasInputH(inout AH1 r,inout AH1 g,inout AH1 b){}
 	#endif
 #endif
 
 #include "ffx_fsr1.h"
 
+#if SAMPLE_FUSED
+// Runs EASU over the tile, each lane takes every 64th pixel.
+// Halo pixels outside the image are clamped to the edge, which is what RCAS would see with a clamped load.
+void FusedEasu(AU1 lane)
+{
+	for (AU1 i = lane; i < FUSED_TILE_DIM * FUSED_TILE_DIM; i += 64u)
+	{
+		ASU2 p = clamp(FusedTileOrigin + ASU2(i % FUSED_TILE_DIM, i / FUSED_TILE_DIM), ASU2(0, 0), ASU2(Const4.zw) - ASU2(1, 1));
+	#if SAMPLE_SLOW_FALLBACK
+		AF3 c;
+		FsrEasuF(c, AU2(p), Const0, Const1, Const2, Const3);
+	#else
+		AH3 h;
+		FsrEasuH(h, AU2(p), Const0, Const1, Const2, Const3);
+		AF3 c = AF3(h);
+	#endif
+		FusedTileR[i] = c.r;
+		FusedTileG[i] = c.g;
+		FusedTileB[i] = c.b;
+	}
+}
+#endif
+
 void CurrFilter(int2 pos)
 {
 #if SAMPLE_BILINEAR
@@ -86,16 +148,21 @@ void CurrFilter(int2 pos)
 		OutputTexture[pos] = AH4(c, 1);
 	#endif
 #endif
-#if SAMPLE_RCAS
+#if SAMPLE_RCAS || SAMPLE_FUSED
+	#if SAMPLE_FUSED
+		AU4 rcasCon = Const4;
+	#else
+		AU4 rcasCon = Const0;
+	#endif
 	#if SAMPLE_SLOW_FALLBACK
 		AF3 c;
-		FsrRcasF(c.r, c.g, c.b, pos, Const0);
+		FsrRcasF(c.r, c.g, c.b, pos, rcasCon);
 		if (Sample.x == 1)
 			c *= c;
 		OutputTexture[pos] = float4(c, 1);
 	#else
 		AH3 c;
-		FsrRcasH(c.r, c.g, c.b, pos, Const0);
+		FsrRcasH(c.r, c.g, c.b, pos, rcasCon);
 		if( Sample.x == 1 )
 			c *= c;
 		OutputTexture[pos] = AH4(c, 1);
@@ -103,11 +170,98 @@ void CurrFilter(int2 pos)
 #endif
 }
 
+#if SAMPLE_EASU_HX2 && !SAMPLE_SLOW_FALLBACK
+// Packed EASU, one call covers the left and right 8x8 tiles of a 16x8 row.
+void CurrFilterHx2(int2 pos)
+{
+	AH2 r, g, b;
+	FsrEasuHx2(r, g, b, pos, Const0, Const1, Const2, Const3);
+	if (Sample.x == 1)
+	{
+		r *= r;
+		g *= g;
+		b *= b;
+	}
+	AH4 c0, c1;
+	FsrEasuDepackHx2(c0, c1, r, g, b);
+	OutputTexture[pos] = AH4(c0.rgb, 1);
+	OutputTexture[pos + int2(8, 0)] = AH4(c1.rgb, 1);
+}
+#endif
+
+#if SAMPLE_RCAS_HX2 && !SAMPLE_SLOW_FALLBACK
+// Film grain in [-0.5, 0.5) for both lanes (pos and pos + (8, 0)): an integer hash of the pixel and frame,
+// independent of the FsrTepdDitHx2() dither so the two don't correlate.
+AH2 GrainHx2(AU2 pos, AU1 frame)
+{
+	AU2 h = (AU2(pos.x, pos.x + 8u) | AU2_(pos.y << 16u)) ^ AU2_(frame * 0x9e3779b9u);
+	h ^= h >> 16u;
+	h *= 0x7feb352du;
+	h ^= h >> 15u;
+	h *= 0x846ca68bu;
+	h ^= h >> 16u;
+	return AH2(AF2(h >> 8u) * AF2_(1.0 / 16777216.0) - AF2_(0.5));
+}
+
+// Packed RCAS, same layout as CurrFilterHx2().
+// SAMPLE_LFGA and SAMPLE_TEPD add grain and dither before the store, both work in linear.
+// The SDR output is treated as gamma 2.0 like FsrTepd*() expects.
+void CurrFilterRcasHx2(int2 pos)
+{
+	AH2 r, g, b;
+	FsrRcasHx2(r, g, b, pos, Const0);
+#if SAMPLE_TEPD || SAMPLE_LFGA
+	bool linearize = true;
+#else
+	bool linearize = (Sample.x == 1);
+#endif
+	if (linearize)
+	{
+		r *= r;
+		g *= g;
+		b *= b;
+	}
+#if SAMPLE_LFGA
+	// Monochrome grain.
+	AH2 grain = GrainHx2(AU2(pos), Sample.y);
+	FsrLfgaHx2(r, g, b, grain, grain, grain, AH1(AF1_AU1(Sample.z)));
+#endif
+	if (Sample.x != 1)
+	{
+	#if SAMPLE_TEPD
+		FsrTepdC8Hx2(r, g, b, FsrTepdDitHx2(pos, Sample.y));
+	#elif SAMPLE_LFGA
+		r = sqrt(r);
+		g = sqrt(g);
+		b = sqrt(b);
+	#endif
+	}
+	AH4 c0, c1;
+	FsrRcasDepackHx2(c0, c1, r, g, b);
+	OutputTexture[pos] = AH4(c0.rgb, 1);
+	OutputTexture[pos + int2(8, 0)] = AH4(c1.rgb, 1);
+}
+#endif
+
 [numthreads(WIDTH, HEIGHT, DEPTH)]
 void mainCS(uint3 LocalThreadId : SV_GroupThreadID, uint3 WorkGroupId : SV_GroupID, uint3 Dtid : SV_DispatchThreadID)
 {
+#if SAMPLE_FUSED
+	FusedTileOrigin = ASU2(WorkGroupId.xy << 4u) - ASU2(1, 1);
+	FusedEasu(LocalThreadId.x);
+	GroupMemoryBarrierWithGroupSync();
+#endif
 	// Do remapping of local xy in workgroup for a more PS-like swizzle pattern.
 	AU2 gxy = ARmp8x8(LocalThreadId.x) + AU2(WorkGroupId.x << 4u, WorkGroupId.y << 4u);
+#if SAMPLE_EASU_HX2 && !SAMPLE_SLOW_FALLBACK
+	CurrFilterHx2(gxy);
+	gxy.y += 8u;
+	CurrFilterHx2(gxy);
+#elif SAMPLE_RCAS_HX2 && !SAMPLE_SLOW_FALLBACK
+	CurrFilterRcasHx2(gxy);
+	gxy.y += 8u;
+	CurrFilterRcasHx2(gxy);
+#else
 	CurrFilter(gxy);
 	gxy.x += 8u;
 	CurrFilter(gxy);
@@ -115,5 +269,5 @@ void mainCS(uint3 LocalThreadId : SV_GroupThreadID, uint3 WorkGroupId : SV_Group
 	CurrFilter(gxy);
 	gxy.x -= 8u;
 	CurrFilter(gxy);
+#endif
 }
-
@@ -704,8 +704,7 @@ void SampleRenderer::OnRender(int displayWidth, int displayHeight, State *pState
     }
 	if (!renderNative)
 	{
-		m_FSR.Upscale(pCmdLst2, displayWidth, displayHeight, pState, &m_ConstantBufferRing, hdr);
-		m_GPUTimer.GetTimeStamp(pCmdLst2, pState->m_nUpscaleType == 1 ? "FSR 1.0" : "Upscaling");
+		m_FSR.Upscale(pCmdLst2, displayWidth, displayHeight, pState, hdr, &m_GPUTimer);
 	}
 		
 	pCmdLst2->RSSetViewports(1, &vpd);
@@ -47,6 +47,12 @@ struct State
 	bool  bUseTAA;
     bool  bUseRcas = true;
     float rcasAttenuation = 0.25f;
+    bool  bUseFusedRcas = false;
+    bool  bUseRcasHx2 = false;
+    bool  bUseEasuHx2 = false; // packed FsrEasuHx2, opt-in until it has been checked against FsrEasuH
+    bool  bUseTepd = false;
+    bool  bUseLfga = false;
+    float lfgaAmount = 0.25f;
 	bool  bIsBenchmarking;
 
 	bool  bDrawLightFrustum;
@@ -95,6 +101,7 @@ public:
 
     bool GetHasTAA() const { return m_HasTAA; }
     void SetHasTAA(bool hasTAA) { m_HasTAA = hasTAA; }
+    bool IsEasuHx2Available() const { return m_FSR.IsEasuHx2Available(); }
 
     const std::vector<TimeStamp> &GetTimingValues() { return m_TimeStamps; }
     std::string& GetScreenshotFileName() { return m_pScreenShotName; }
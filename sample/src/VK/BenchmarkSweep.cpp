@@ -0,0 +1,199 @@
+// FidelityFX Super Resolution Sample
+//
+// Copyright (c) 2021 Advanced Micro Devices, Inc. All rights reserved.
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "stdafx.h"
+#include "SampleRenderer.h"
+#include "BenchmarkSweep.h"
+#include "TimingHistory.h"
+#include <algorithm>
+
+bool BenchmarkSweep::OnCreate(const json& benchmarkSettings, bool fp16Supported, const std::string& deviceName, const std::string& driverVersion)
+{
+	if (benchmarkSettings.find("sweep") == benchmarkSettings.end())
+		return false;
+	const json& sweep = benchmarkSettings["sweep"];
+
+	std::vector<int> upscaleTypes = sweep.value("upscaleTypes", std::vector<int>{ 0, 1, 2 });
+	std::vector<float> ratios = sweep.value("ratios", std::vector<float>{ 1.3f, 1.5f, 1.7f, 2.0f });
+	std::vector<bool> rcas = sweep.value("rcas", std::vector<bool>{ false, true });
+	std::vector<float> rcasAttenuations = sweep.value("rcasAttenuations", std::vector<float>{ 0.25f });
+	std::vector<bool> fp16 = sweep.value("fp16", std::vector<bool>{ true, false });
+	// The timings of a frame are read back backBufferCount frames later, the warm-up has to cover at least that.
+	m_warmUpFrames = std::max<uint32_t>(sweep.value("warmUpFrames", benchmarkSettings.value("warmUpFrames", m_warmUpFrames)), backBufferCount + 1);
+	m_frames = std::max<uint32_t>(sweep.value("frames", m_frames), 1);
+	m_filename = sweep.value("resultsFilename", std::string("FSRSweep.csv"));
+	m_deviceName = deviceName;
+	m_driverVersion = driverVersion;
+
+	if (!fp16Supported && std::find(fp16.begin(), fp16.end(), true) != fp16.end())
+	{
+		Trace("Sweep: the device has no fp16, only the fallback is measured\n");
+		fp16 = { false };
+	}
+
+	m_cells.clear();
+	for (int type : upscaleTypes)
+	{
+		Cell cell;
+		cell.upscaleType = type;
+		cell.rcas = false;
+		cell.fp16 = fp16.empty() ? false : fp16.front();
+		if (type == 2)
+		{
+			cell.ratio = 1.0f;
+			m_cells.push_back(cell);
+			continue;
+		}
+		for (float ratio : ratios)
+		{
+			cell.ratio = ratio;
+			if (type == 0)
+			{
+				m_cells.push_back(cell);
+				continue;
+			}
+			for (bool precision : fp16)
+			{
+				cell.fp16 = precision;
+				for (bool sharpen : rcas)
+				{
+					cell.rcas = sharpen;
+					if (!sharpen)
+					{
+						// The cell is reused, don't carry the attenuation of an earlier sharpened one into the results.
+						cell.rcasAttenuation = Cell().rcasAttenuation;
+						m_cells.push_back(cell);
+						continue;
+					}
+					for (float attenuation : rcasAttenuations)
+					{
+						cell.rcasAttenuation = attenuation;
+						m_cells.push_back(cell);
+					}
+				}
+			}
+		}
+	}
+
+	m_results.clear();
+	m_results.reserve(m_cells.size());
+	m_cell = 0;
+	m_frame = 0;
+	Trace(format("Sweep: %d cells of %d + %d frames\n", (int)m_cells.size(), m_warmUpFrames, m_frames));
+	return !m_cells.empty();
+}
+
+bool BenchmarkSweep::OnFrame(const std::vector<TimeStamp>& timeStamps, const std::vector<FSR_Filter::PassStatistics>& passStatistics)
+{
+	if (IsDone())
+		return false;
+
+	if (m_frame == m_warmUpFrames)
+	{
+		m_results.push_back(Result());
+		m_results.back().cell = m_cells[m_cell];
+	}
+	if (m_frame >= m_warmUpFrames)
+	{
+		Result& result = m_results.back();
+		for (const TimeStamp& timeStamp : timeStamps)
+		{
+			std::vector<float>& samples = result.samples[timeStamp.m_label];
+			if (samples.empty())
+				result.labels.push_back(timeStamp.m_label);
+			samples.push_back(timeStamp.m_microseconds);
+		}
+		for (const FSR_Filter::PassStatistics& pass : passStatistics)
+			result.invocations[pass.label] = pass.invocations;
+	}
+
+	if (++m_frame < m_warmUpFrames + m_frames)
+		return false;
+	m_frame = 0;
+	m_cell++;
+	return true;
+}
+
+// Nearest rank p99, the median averages the two middle samples.
+static void Percentiles(std::vector<float> samples, float* pMedian, float* pP99)
+{
+	std::sort(samples.begin(), samples.end());
+	size_t count = samples.size();
+	*pMedian = (count % 2) ? samples[count / 2] : 0.5f * (samples[count / 2 - 1] + samples[count / 2]);
+	*pP99 = TimingHistory::Percentile(samples, 0.99f);
+}
+
+void BenchmarkSweep::WriteResults() const
+{
+	bool asJson = (m_filename.size() >= 5) && (m_filename.compare(m_filename.size() - 5, 5, ".json") == 0);
+	std::ofstream file(m_filename);
+	if (!file)
+	{
+		Trace(format("Sweep: can't write %s\n", m_filename.c_str()));
+		return;
+	}
+
+	if (asJson)
+	{
+		json results;
+		results["device"] = m_deviceName;
+		results["driver"] = m_driverVersion;
+		results["frames"] = m_frames;
+		for (const Result& result : m_results)
+		{
+			json cell;
+			cell["upscaleType"] = result.cell.upscaleType;
+			cell["ratio"] = result.cell.ratio;
+			cell["rcas"] = result.cell.rcas;
+			cell["rcasAttenuation"] = result.cell.rcasAttenuation;
+			cell["fp16"] = result.cell.fp16;
+			for (const std::string& label : result.labels)
+			{
+				float median, p99;
+				Percentiles(result.samples.at(label), &median, &p99);
+				json pass = { { "name", label }, { "median", median }, { "p99", p99 } };
+				if (result.invocations.count(label))
+					pass["invocations"] = result.invocations.at(label);
+				cell["passes"].push_back(pass);
+			}
+			results["cells"].push_back(cell);
+		}
+		file << results.dump(2);
+	}
+	else
+	{
+		file << "device,driver,upscaleType,ratio,rcas,rcasAttenuation,fp16,pass,frames,median_us,p99_us,invocations\n";
+		for (const Result& result : m_results)
+		{
+			for (const std::string& label : result.labels)
+			{
+				const std::vector<float>& samples = result.samples.at(label);
+				float median, p99;
+				Percentiles(samples, &median, &p99);
+				// Empty for the passes that aren't FSR dispatches.
+				std::map<std::string, uint64_t>::const_iterator invocations = result.invocations.find(label);
+				std::string invocationsText = (invocations != result.invocations.end()) ? std::to_string(invocations->second) : std::string();
+				file << format("\"%s\",\"%s\",%d,%.3f,%d,%.3f,%d,\"%s\",%d,%.2f,%.2f,%s\n", m_deviceName.c_str(), m_driverVersion.c_str(),
+					result.cell.upscaleType, result.cell.ratio, result.cell.rcas ? 1 : 0, result.cell.rcasAttenuation, result.cell.fp16 ? 1 : 0,
+					label.c_str(), (int)samples.size(), median, p99, invocationsText.c_str());
+			}
+		}
+	}
+	Trace(format("Sweep: %d cells written to %s\n", (int)m_results.size(), m_filename.c_str()));
+}
@@ -0,0 +1,76 @@
+// FidelityFX Super Resolution Sample
+//
+// Copyright (c) 2021 Advanced Micro Devices, Inc. All rights reserved.
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+// Runs every combination of the upscaling settings listed in the "sweep" object of a scene's BenchmarkSettings, e.g.
+//   "sweep": {
+//     "upscaleTypes": [ 0, 1, 2 ],                 // bilinear, FSR, native
+//     "ratios": [ 1.3, 1.5, 1.7, 2.0, 1.25 ],      // the presets or any custom factor
+//     "rcas": [ false, true ],
+//     "rcasAttenuations": [ 0.0, 0.25, 1.0 ],      // only for the cells with RCAS on
+//     "fp16": [ true, false ],                     // false runs the slow fallback
+//     "warmUpFrames": 50, "frames": 300,
+//     "resultsFilename": "FSRSweep.csv"            // or .json
+//   }
+// Settings that don't apply to a type are not multiplied out: native is a single cell, bilinear has one per ratio.
+// Each cell renders the same frame (the scene's default camera, animation stopped) and keeps the per pass GPU timings
+// once its warm-up frames are done. The median and the 99th percentile of every pass end up in one file per run,
+// with the compute shader invocations of the FSR passes when the device has pipeline statistics.
+class BenchmarkSweep
+{
+public:
+	struct Cell
+	{
+		int                         upscaleType = 1;
+		float                       ratio = 1.5f;
+		bool                        rcas = true;
+		float                       rcasAttenuation = 0.25f;
+		bool                        fp16 = true;
+	};
+
+	// False when the settings have no sweep, the regular benchmark runs then.
+	bool OnCreate(const json& benchmarkSettings, bool fp16Supported, const std::string& deviceName, const std::string& driverVersion);
+
+	const Cell& GetCell() const { return m_cells[m_cell]; }
+	bool IsDone() const { return m_cell >= m_cells.size(); }
+	// Call once per frame with the timings and statistics the renderer just read back. Returns true when the sweep moved on
+	// to the next cell, or finished, and the caller has to apply it.
+	bool OnFrame(const std::vector<TimeStamp>& timeStamps, const std::vector<FSR_Filter::PassStatistics>& passStatistics);
+	void WriteResults() const;
+
+private:
+	struct Result
+	{
+		Cell                        cell;
+		std::vector<std::string>    labels; // in profiler order
+		std::map<std::string, std::vector<float>> samples;
+		std::map<std::string, uint64_t> invocations; // same for every frame of a cell, the last one is kept
+	};
+
+	std::vector<Cell>               m_cells;
+	std::vector<Result>             m_results;
+	size_t                          m_cell = 0;
+	uint32_t                        m_frame = 0;
+	uint32_t                        m_warmUpFrames = 50;
+	uint32_t                        m_frames = 300;
+	std::string                     m_filename;
+	std::string                     m_deviceName;
+	std::string                     m_driverVersion;
+};
@@ -0,0 +1,72 @@
+// FidelityFX Super Resolution Sample
+//
+// Copyright (c) 2021 Advanced Micro Devices, Inc. All rights reserved.
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+// Picks the render scale (render / display size) that holds the GPU frame time on a target.
+// The render targets stay allocated at display size and FSR gets the viewport through FsrEasuConOffset(), so a new scale is only new constants.
+//
+// PID in velocity form: the output is a change of scale, so there is no integrator to wind up while the scale sits on a clamp.
+// The error is relative to the target, which keeps the gains independent of the frame time being aimed for.
+// The GPU timings arrive a few frames late, the gains are low enough for that not to oscillate.
+class DynamicResolution
+{
+public:
+	void Reset(float scale)
+	{
+		m_scale = Clamp(scale);
+		m_frameTime = 0.0f;
+		m_error[0] = m_error[1] = 0.0f;
+	}
+
+	// Frame times in milliseconds, returns the scale for the next frame.
+	float Update(float gpuFrameTime, float targetFrameTime)
+	{
+		if (gpuFrameTime <= 0.0f || targetFrameTime <= 0.0f)
+			return m_scale;
+		// Smooth a bit so the derivative doesn't react to single frame spikes.
+		m_frameTime = (m_frameTime == 0.0f) ? gpuFrameTime : m_frameTime + s_smoothing * (gpuFrameTime - m_frameTime);
+
+		float error = (targetFrameTime - m_frameTime) / targetFrameTime;
+		float delta = s_kP * (error - m_error[0]) + s_kI * error + s_kD * (error - 2.0f * m_error[0] + m_error[1]);
+		m_error[1] = m_error[0];
+		m_error[0] = error;
+		m_scale = Clamp(m_scale + delta);
+		return m_scale;
+	}
+
+	float GetScale() const { return m_scale; }
+	float GetFilteredFrameTime() const { return m_frameTime; }
+
+	// Performance mode (2x) up to native.
+	static constexpr float s_minScale = 0.5f;
+	static constexpr float s_maxScale = 1.0f;
+
+private:
+	static float Clamp(float scale) { return (scale < s_minScale) ? s_minScale : ((scale > s_maxScale) ? s_maxScale : scale); }
+
+	static constexpr float s_kP = 0.10f;
+	static constexpr float s_kI = 0.04f;
+	static constexpr float s_kD = 0.02f;
+	static constexpr float s_smoothing = 0.25f;
+
+	float                           m_scale = 1.0f;
+	float                           m_frameTime = 0.0f;
+	float                           m_error[2] = {}; // last two errors, newest first
+};
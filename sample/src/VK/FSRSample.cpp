@@ -67,8 +67,16 @@ void FSRSample::OnParseCommandLine(LPSTR lpCmdLine, uint32_t* pWidth, uint32_t*
         m_VsyncEnabled = jData.value("vsync", m_VsyncEnabled);
         m_FreesyncHDROptionEnabled = jData.value("FreesyncHDROptionEnabled", m_FreesyncHDROptionEnabled);
         m_state.bIsBenchmarking = jData.value("benchmark", m_state.bIsBenchmarking);
+        m_state.bHiddenWindow = jData.value("hiddenWindow", m_state.bHiddenWindow);
+        std::string traceFilename = jData.value("traceFilename", std::string());
+        if (!traceFilename.empty())
+        {
+            m_traceFilename = traceFilename;
+            m_timingHistory.StartTrace();
+        }
         m_fontSize = jData.value("fontsize", m_fontSize);
         m_bGlsl = jData.value("vulkanGlsl", m_bGlsl);
+        m_bParallelCreate = jData.value("parallelCreate", m_bParallelCreate);
     };
 
     //read json globals from commandline
@@ -112,11 +120,46 @@ void FSRSample::OnParseCommandLine(LPSTR lpCmdLine, uint32_t* pWidth, uint32_t*
     json globals = m_jsonConfigFile["globals"];
     process(globals);
 
+    // The hidden window only makes sense for the benchmark, its camera sequence drives the frames and it exits when done.
+    if (m_state.bHiddenWindow)
+    {
+        m_state.bIsBenchmarking = true;
+        m_VsyncEnabled = false;
+        m_fullscreenMode = PRESENTATIONMODE_WINDOWED;
+    }
+
     // get the list of scenes
     for (const auto & scene : m_jsonConfigFile["scenes"])
         m_sceneNames.push_back(scene["name"]);
 }
 
+//--------------------------------------------------------------------------------------
+//
+// IsHiddenWindowRequested
+//
+//--------------------------------------------------------------------------------------
+bool FSRSample::IsHiddenWindowRequested(LPSTR lpCmdLine)
+{
+    // Same sources and order as OnParseCommandLine(), the config file wins. Errors are left for it to report.
+    bool hidden = false;
+    try
+    {
+        if (strlen(lpCmdLine) > 0)
+            hidden = json::parse(lpCmdLine).value("hiddenWindow", hidden);
+        std::ifstream f("FSRSample.json");
+        if (f)
+        {
+            json config;
+            f >> config;
+            hidden = config["globals"].value("hiddenWindow", hidden);
+        }
+    }
+    catch (json::parse_error)
+    {
+    }
+    return hidden;
+}
+
 //--------------------------------------------------------------------------------------
 //
 // OnCreate
@@ -124,13 +167,15 @@ void FSRSample::OnParseCommandLine(LPSTR lpCmdLine, uint32_t* pWidth, uint32_t*
 //--------------------------------------------------------------------------------------
 void FSRSample::OnCreate()
 {
+    m_startTime = MillisecondsNow();
+
     // Init the shader compiler
     InitDirectXCompiler();
     CreateShaderCache();
 
     // Create a instance of the renderer and initialize it, we need to do that for each GPU
     m_Node = new SampleRenderer();
-    m_Node->OnCreate(&m_device, &m_swapChain, m_fontSize, m_bGlsl);
+    m_Node->OnCreate(&m_device, &m_swapChain, m_fontSize, m_bGlsl, m_bParallelCreate);
 
     // init GUI (non gfx stuff)
     ImGUI_Init((void *)m_windowHwnd);
@@ -167,6 +212,11 @@ void FSRSample::OnCreate()
 //--------------------------------------------------------------------------------------
 void FSRSample::OnDestroy()
 {
+    CancelSceneParse();
+
+    if (m_timingHistory.IsTracing())
+        m_timingHistory.StopTrace(m_traceFilename);
+
     ImGUI_Shutdown();
 
     m_device.GPUFlush();
@@ -231,6 +281,77 @@ void FSRSample::OnResize(bool resizeRender)
     m_state.camera.SetFov(AMD_PI_OVER_4, m_Width, m_Height, 0.1f, 1000.0f);
 }
 
+//--------------------------------------------------------------------------------------
+//
+// OnRenderResolutionChanged
+//
+//--------------------------------------------------------------------------------------
+void FSRSample::OnRenderResolutionChanged()
+{
+    // When the targets keep their size only the viewport changes, the FSR constants follow it on the next frame and nothing needs to be flushed.
+    double start = MillisecondsNow();
+    uint32_t targetWidth = m_state.renderTargetWidth;
+    uint32_t targetHeight = m_state.renderTargetHeight;
+    RefreshRenderResolution();
+    m_resolutionChangeReused = (targetWidth == m_state.renderTargetWidth) && (targetHeight == m_state.renderTargetHeight);
+    if (!m_resolutionChangeReused)
+    {
+        m_device.GPUFlush();
+        OnResize(true);
+    }
+    m_resolutionChangeTime = (float)(MillisecondsNow() - start);
+    m_timingHistory.Reset();
+    Trace(format("Render resolution %ux%u in %ux%u targets: %.2f ms (%s)\n", m_state.renderWidth, m_state.renderHeight, m_state.renderTargetWidth, m_state.renderTargetHeight, m_resolutionChangeTime, m_resolutionChangeReused ? "reused" : "reallocated"));
+}
+
+//--------------------------------------------------------------------------------------
+//
+// ApplySweepCell
+//
+//--------------------------------------------------------------------------------------
+void FSRSample::ApplySweepCell()
+{
+    const BenchmarkSweep::Cell& cell = m_sweep.GetCell();
+    m_state.m_nUpscaleType = cell.upscaleType;
+    m_nUpscaleRatio = 4;
+    m_fUpscaleRatio = cell.ratio;
+    m_state.bUseRcas = cell.rcas;
+    m_state.rcasAttenuation = cell.rcasAttenuation;
+    m_state.bUseFp16 = cell.fp16;
+    // Only the plain passes are measured, on the whole frame
+    m_state.bUseFusedRcas = false;
+    m_state.bUseRcasHx2 = false;
+    m_state.bUseEasuHx2 = false;
+    m_state.bUseTepd = false;
+    m_state.bUseLfga = false;
+    m_state.bCompareFused = false;
+    m_state.bSplitScreen = false;
+    m_state.bUseAsyncCompute = false;
+    m_state.bDynamicResolution = false;
+    OnRenderResolutionChanged();
+    m_state.mipBias = (cell.upscaleType == 1) ? log2f((float)m_state.renderWidth / m_Width) : 0.0f;
+}
+
+//--------------------------------------------------------------------------------------
+//
+// UpdateDynamicResolution
+//
+//--------------------------------------------------------------------------------------
+void FSRSample::UpdateDynamicResolution()
+{
+    // The last entry is the whole GPU frame
+    const std::vector<TimeStamp>& timeStamps = m_Node->GetTimingValues();
+    if (timeStamps.empty() || !m_Width || !m_Height)
+        return;
+
+    float scale = m_dynamicResolution.Update(timeStamps.back().m_microseconds / 1000.0f, m_state.targetFrameTime);
+
+    // Only the viewport moves, in steps of 8 pixels so the FSR constants don't change every frame for sub pixel differences.
+    m_state.renderWidth = std::min<uint32_t>(m_state.renderTargetWidth, std::max<uint32_t>(8, (uint32_t(m_Width * scale) + 4) & ~7u));
+    m_state.renderHeight = std::min<uint32_t>(m_state.renderTargetHeight, std::max<uint32_t>(8, (uint32_t(m_Height * scale) + 4) & ~7u));
+    m_state.mipBias = log2f((float)m_state.renderWidth / m_Width);
+}
+
 //--------------------------------------------------------------------------------------
 //
 // LoadScene
@@ -240,6 +361,9 @@ void FSRSample::LoadScene(int sceneIndex)
 {
     json scene = m_jsonConfigFile["scenes"][sceneIndex];
 
+    // A scene picked while the previous one is still parsing replaces it
+    CancelSceneParse();
+
     // release everything and load the GLTF, just the light json data, the rest (textures and geometry) will be done in the main loop
     if (m_pGltfLoader != NULL)
     {
@@ -247,18 +371,20 @@ void FSRSample::LoadScene(int sceneIndex)
         m_Node->OnDestroyWindowSizeDependentResources();
         m_Node->OnDestroy();
         m_pGltfLoader->Unload();
-        m_Node->OnCreate(&m_device, &m_swapChain, m_fontSize, m_bGlsl);
+        m_Node->OnCreate(&m_device, &m_swapChain, m_fontSize, m_bGlsl, m_bParallelCreate);
         m_Node->OnCreateWindowSizeDependentResources(&m_swapChain, m_Width, m_Height, &m_state);
     }
 
     delete(m_pGltfLoader);
-    m_pGltfLoader = new GLTFCommon();
-    if (m_pGltfLoader->Load(scene["directory"], scene["filename"]) == false)
-    {
-        MessageBox(NULL, "The selected model couldn't be found, please check the documentation", "Cauldron Panic!", MB_ICONERROR);
-        exit(0);
-    }
+    m_pGltfLoader = NULL;
 
+    // The glTF is parsed on a worker, the frames keep going with the sky dome and the progress bar until OnSceneParsed()
+    m_pGltfParsing = new GLTFCommon();
+    m_parsingScene = sceneIndex;
+    GLTFCommon *pGltfParsing = m_pGltfParsing;
+    std::string directory = scene["directory"];
+    std::string filename = scene["filename"];
+    m_gltfParse = std::async(std::launch::async, [pGltfParsing, directory, filename]() { return pGltfParsing->Load(directory, filename); });
 
     // Load the UI settings, and also some defaults cameras and lights, in case the GLTF has none
     {
@@ -273,6 +399,60 @@ void FSRSample::LoadScene(int sceneIndex)
         LOAD(scene, "emmisiveFactor", m_state.emmisiveFactor);
         LOAD(scene, "skyDomeType", m_state.skyDomeType);
 
+        // TAA decides whether the targets can be bigger than the render resolution
+        if (m_state.renderTargetWidth)
+            OnRenderResolutionChanged();
+
+        // set default camera
+        //
+        json camera = scene["camera"];
+        m_activeCamera = scene.value("activeCamera", m_activeCamera);
+        math::Vector4 from = GetVector(GetElementJsonArray(camera, "defaultFrom", { 0.0, 0.0, 10.0 }));
+        math::Vector4 to = GetVector(GetElementJsonArray(camera, "defaultTo", { 0.0, 0.0, 0.0 }));
+        m_state.camera.LookAt(from, to);
+        m_roll = m_state.camera.GetYaw();
+        m_pitch = m_state.camera.GetPitch();
+        m_distance = m_state.camera.GetDistance();
+
+        // indicate the mainloop we started loading a GLTF and it needs to load the rest (textures and geometry)
+        m_loadingScene = true;
+    }
+}
+
+//--------------------------------------------------------------------------------------
+//
+// CancelSceneParse
+//
+//--------------------------------------------------------------------------------------
+void FSRSample::CancelSceneParse()
+{
+    // The worker can't be interrupted, it has to finish with the GLTFCommon before that can be deleted.
+    if (m_pGltfParsing)
+    {
+        m_gltfParse.wait();
+        delete m_pGltfParsing;
+        m_pGltfParsing = NULL;
+    }
+}
+
+//--------------------------------------------------------------------------------------
+//
+// OnSceneParsed, the part of LoadScene that needs the glTF
+//
+//--------------------------------------------------------------------------------------
+void FSRSample::OnSceneParsed()
+{
+    json scene = m_jsonConfigFile["scenes"][m_parsingScene];
+    bool loaded = m_gltfParse.get();
+    m_pGltfLoader = m_pGltfParsing;
+    m_pGltfParsing = NULL;
+    if (loaded == false)
+    {
+        MessageBox(NULL, "The selected model couldn't be found, please check the documentation", "Cauldron Panic!", MB_ICONERROR);
+        exit(0);
+    }
+
+    {
         // Add a default light in case there are none
         //
         if (m_pGltfLoader->m_lights.size() == 0)
@@ -291,17 +471,6 @@ void FSRSample::LoadScene(int sceneIndex)
             m_pGltfLoader->AddLight(n, l);
         }
 
-        // set default camera
-        //
-        json camera = scene["camera"];
-        m_activeCamera = scene.value("activeCamera", m_activeCamera);
-        math::Vector4 from = GetVector(GetElementJsonArray(camera, "defaultFrom", { 0.0, 0.0, 10.0 }));
-        math::Vector4 to = GetVector(GetElementJsonArray(camera, "defaultTo", { 0.0, 0.0, 0.0 }));
-        m_state.camera.LookAt(from, to);
-        m_roll = m_state.camera.GetYaw();
-        m_pitch = m_state.camera.GetPitch();
-        m_distance = m_state.camera.GetDistance();
-
         // set benchmarking state if enabled 
         //
         if (m_state.bIsBenchmarking)
@@ -309,11 +478,10 @@ void FSRSample::LoadScene(int sceneIndex)
             std::string deviceName;
             std::string driverVersion;
             m_device.GetDeviceInfo(&deviceName, &driverVersion);
-            BenchmarkConfig(scene["BenchmarkSettings"], m_activeCamera, m_pGltfLoader, deviceName, driverVersion);
+            m_sweeping = m_sweep.OnCreate(scene["BenchmarkSettings"], m_device.IsFp16Supported(), deviceName, driverVersion);
+            if (!m_sweeping)
+                BenchmarkConfig(scene["BenchmarkSettings"], m_activeCamera, m_pGltfLoader, deviceName, driverVersion);
         }
-
-        // indicate the mainloop we started loading a GLTF and it needs to load the rest (textures and geometry)
-        m_loadingScene = true;
     }
 }
 
@@ -379,46 +547,40 @@ void FSRSample::HandleInput(const ImGuiIO& io)
     if (fnIsKeyTriggered('1'))
     {
         m_state.m_nUpscaleType = 0;
-        m_device.GPUFlush();
-        OnResize(true);
+        OnRenderResolutionChanged();
     }
     if (fnIsKeyTriggered('2'))
     {
         m_state.m_nUpscaleType = 1;
         m_nUpscaleRatio = 3;
-        m_device.GPUFlush();
-        OnResize(true);
+        OnRenderResolutionChanged();
         m_state.mipBias = mipBias[m_nUpscaleRatio];
     }
     if (fnIsKeyTriggered('3'))
     {
         m_state.m_nUpscaleType = 1;
         m_nUpscaleRatio = 2;
-        m_device.GPUFlush();
-        OnResize(true);
+        OnRenderResolutionChanged();
         m_state.mipBias = mipBias[m_nUpscaleRatio];
     }
     if (fnIsKeyTriggered('4'))
     {
         m_state.m_nUpscaleType = 1;
         m_nUpscaleRatio = 1;
-        m_device.GPUFlush();
-        OnResize(true);
+        OnRenderResolutionChanged();
         m_state.mipBias = mipBias[m_nUpscaleRatio];
     }
     if (fnIsKeyTriggered('5'))
     {
         m_state.m_nUpscaleType = 1;
         m_nUpscaleRatio = 0;
-        m_device.GPUFlush();
-        OnResize(true);
+        OnRenderResolutionChanged();
         m_state.mipBias = mipBias[m_nUpscaleRatio];
     }
     if (fnIsKeyTriggered('0'))
     {
         m_state.m_nUpscaleType = 2;
-        m_device.GPUFlush();
-        OnResize(true);
+        OnRenderResolutionChanged();
     }
 }
 void FSRSample::UpdateCamera(Camera& cam, const ImGuiIO& io)
@@ -473,10 +635,11 @@ void FSRSample::UpdateCamera(Camera& cam, const ImGuiIO& io)
 #include "imgui_internal.h"
 void FSRSample::BuildUI()
 {
-    // if we haven't initialized GLTFLoader yet, don't draw UI.
+    // if we haven't initialized GLTFLoader yet, don't draw UI. Start loading it unless that is already happening.
     if (m_pGltfLoader == nullptr)
     {
-        LoadScene(m_activeScene);
+        if (m_pGltfParsing == NULL)
+            LoadScene(m_activeScene);
         return;
     }
     auto fnDisableUIStateBegin = [](const bool& bEnable)
@@ -578,34 +741,87 @@ void FSRSample::BuildUI()
 			const char* modes[] = { "Bilinear [Hotkey 1]", "FSR 1.0 [Hotkeys 2-5]", "Native (no upscaling) [Hotkey 0]" };
 			if (ImGui::Combo("Upscaling", &m_state.m_nUpscaleType, modes, _countof(modes)))
 			{
-                m_device.GPUFlush();
-				OnResize(true);
+				OnRenderResolutionChanged();
 			}
+            bool dynamicResolution = m_state.bDynamicResolution && m_state.m_nUpscaleType < 2;
 			if (m_state.m_nUpscaleType < 2)
+            {
+                if (ImGui::Checkbox("Dynamic resolution", &m_state.bDynamicResolution))
+                {
+                    OnRenderResolutionChanged();
+                }
+            }
+			if (dynamicResolution)
+            {
+                ImGui::SliderFloat("Target GPU time (ms)", &m_state.targetFrameTime, 2.0f, 50.0f);
+                ImGui::Text("Scale %.2f, GPU time %.2f ms (filtered)", m_dynamicResolution.GetScale(), m_dynamicResolution.GetFilteredFrameTime());
+                ImGui::Text("Mip LOD bias: %.2f", m_state.mipBias);
+                if (m_state.bUseTAA)
+                    ImGui::Text("TAA is off while the resolution changes");
+            }
+			else if (m_state.m_nUpscaleType < 2)
             {
                 const char* ratios[] = { "Ultra Quality (1.3x) [Hotkey 5]", "Quality (1.5x) [Hotkey 4]", "Balanced (1.7x) [Hotkey 3]", "Performance (2x) [Hotkey 2]", "Custom" };
                 if (ImGui::Combo("Scale mode", &m_nUpscaleRatio, ratios, _countof(ratios)))
                 {
-                    m_device.GPUFlush();
-                    OnResize(true);
+                    OnRenderResolutionChanged();
                 }
                 if (m_state.m_nUpscaleType == 1 && m_nUpscaleRatio < 4)
                     m_state.mipBias = mipBias[m_nUpscaleRatio];
                 if (m_nUpscaleRatio == 4 && ImGui::SliderFloat("Custom factor", &m_fUpscaleRatio, 1.0f, 2.0f))
                 {
-                    m_device.GPUFlush();
-                    OnResize(true);
+                    OnRenderResolutionChanged();
                 }
             }
             else
                 m_state.mipBias = mipBias[4];
             if (m_state.m_nUpscaleType == 1)
             {
+                if (m_device.IsFp16Supported())
+                    ImGui::Checkbox("FP16 (off: slow fallback)", &m_state.bUseFp16);
+                bool packedEasu = m_device.IsFp16Supported() && m_state.bUseFp16 && m_Node->IsEasuHx2Available();
+                if (packedEasu)
+                    ImGui::Checkbox("Packed EASU (Hx2)", &m_state.bUseEasuHx2);
+                packedEasu = packedEasu && m_state.bUseEasuHx2;
                 ImGui::Checkbox("FSR 1.0 Sharpening", &m_state.bUseRcas);
                 if (m_state.bUseRcas)
+                {
                     ImGui::SliderFloat("Sharpening attenuation", &m_state.rcasAttenuation, 0.0f, 2.0f);
+                    ImGui::Checkbox("Fused EASU + RCAS", &m_state.bUseFusedRcas);
+                    if (!m_state.bUseFusedRcas)
+                    {
+                        ImGui::Checkbox("Packed RCAS (Hx2)", &m_state.bUseRcasHx2);
+                        if (m_state.bUseRcasHx2)
+                        {
+                            ImGui::Checkbox("Temporal dither (TEPD)", &m_state.bUseTepd);
+                            ImGui::Checkbox("Film grain (LFGA)", &m_state.bUseLfga);
+                            if (m_state.bUseLfga)
+                                ImGui::SliderFloat("Grain amount", &m_state.lfgaAmount, 0.0f, 1.0f);
+                        }
+                    }
+                }
+                // The reference is FsrEasuH and the regular two-pass RCAS, the packed RCAS would add its own differences.
+                bool fusedRcas = m_state.bUseRcas && m_state.bUseFusedRcas;
+                bool packedRcas = m_state.bUseRcas && !m_state.bUseFusedRcas && m_state.bUseRcasHx2;
+                if (fusedRcas || (packedEasu && !packedRcas))
+                {
+                    if (ImGui::Button(fusedRcas ? "Compare with two-pass" : "Compare with FsrEasuH"))
+                        m_state.bCompareFused = true;
+                    const FSR_Filter::FusedComparison &comparison = m_Node->GetFusedComparison();
+                    if (comparison.available && !comparison.supported)
+                        ImGui::Text("Comparison not supported for this output format");
+                    else if (comparison.available)
+                        ImGui::Text("Max diff %u/%u, mean %.4f, %.2f%% of pixels above 1", comparison.maxDiff, comparison.maxValue, comparison.meanDiff, comparison.percentAboveOne);
+                }
+                ImGui::Checkbox("Split screen vs bilinear", &m_state.bSplitScreen);
+                if (m_state.bSplitScreen && m_state.bUseRcas)
+                    ImGui::Checkbox("Third strip: EASU without RCAS", &m_state.bSplitScreenEasu);
+            }
+            if (dynamicResolution)
+            {
+                // UpdateDynamicResolution() sets it from the scale every frame
             }
-            if (m_state.m_nUpscaleType)
+            else if (m_state.m_nUpscaleType)
             {
                 ImGui::SliderFloat("Mip LOD bias", &m_state.mipBias, -3.0f, 0.0f);
                 if (m_state.m_nUpscaleType == 2)
@@ -616,7 +832,32 @@ void FSRSample::BuildUI()
             }
             else
                 m_state.mipBias = 0.0f;
+            if (m_state.m_nUpscaleType != 2)
+            {
+                if (m_Node->IsAsyncComputeSupported())
+                {
+                    // The render output and the FSR intermediary only alias the shadow map without it, they have to be placed again.
+                    if (ImGui::Checkbox("Async compute upscaling", &m_state.bUseAsyncCompute))
+                    {
+                        m_device.GPUFlush();
+                        OnResize(true);
+                    }
+                    const FSR_AsyncCompute::Stats &stats = m_Node->GetAsyncComputeStats();
+                    if (m_state.bUseAsyncCompute && stats.available)
+                    {
+                        ImGui::Text("Upscale %.1f us on the compute queue", stats.upscale);
+                        ImGui::Text("Overlap with graphics work is not measured");
+                    }
+                }
+                else
+                    ImGui::Text("Async compute: no separate compute queue, upscaling on graphics");
+            }
+            ImGui::Checkbox("Record scene on workers", &m_state.bParallelRecording);
             ImGui::Text("Render resolution: %dx%d", m_state.renderWidth, m_state.renderHeight);
+            if (m_state.renderTargetWidth != m_state.renderWidth || m_state.renderTargetHeight != m_state.renderHeight)
+                ImGui::Text("Render targets: %dx%d", m_state.renderTargetWidth, m_state.renderTargetHeight);
+            if (m_resolutionChangeTime > 0.0f)
+                ImGui::Text("Last change: %.2f ms, %s", m_resolutionChangeTime, m_resolutionChangeReused ? "targets reused" : "targets reallocated");
             ImGui::Text("Display resolution: %dx%d", m_Width, m_Height);
         }
 
@@ -630,7 +871,8 @@ void FSRSample::BuildUI()
 
             ImGui::SliderFloat("Exposure", &m_state.exposure, 0.0f, 4.0f);
 
-            ImGui::Checkbox("TAA", &m_state.bUseTAA);
+            if (ImGui::Checkbox("TAA", &m_state.bUseTAA))
+                OnRenderResolutionChanged();
         }
 
         ImGui::Spacing();
@@ -837,6 +1079,9 @@ void FSRSample::BuildUI()
         ImGui::Text("GPU        : %s", m_systemInfo.mGPUName.c_str());
         ImGui::Text("CPU        : %s", m_systemInfo.mCPUName.c_str());
         ImGui::Text("FPS        : %d", sFps);
+        ImGui::Text("Startup    : %.0f ms to first frame, renderer %.0f ms (%s)", m_timeToFirstFrame, m_Node->GetCreateTime(), m_bParallelCreate ? "parallel" : "serial");
+        const TransientAllocator &targets = m_Node->GetTransientAllocator();
+        ImGui::Text("Targets    : %.1f MB %s, %.1f MB dedicated", targets.GetAllocatedSize() / (1024.0f * 1024.0f), targets.IsAliasing() ? "aliased" : "not aliased", targets.GetDedicatedSize() / (1024.0f * 1024.0f));
 
         if (ImGui::CollapsingHeader("GPU Timings", ImGuiTreeNodeFlags_DefaultOpen))
         {
@@ -858,12 +1103,40 @@ void FSRSample::BuildUI()
             }
             ImGui::PlotLines("", FRAME_TIME_ARRAY, NUM_FRAMES, 0, "GPU frame time (us)", 0.0f, FRAME_TIME_GRAPH_MAX_VALUES[iFrameTimeGraphMaxValue], ImVec2(0, 80));
 
+            // Rolling percentiles over the last TimingHistory::s_historyFrames frames, restarted when the render resolution changes
+            const float unit = m_state.bShowMilliseconds ? 1000.0f : 1.0f;
+            const char* pStrUnit = m_state.bShowMilliseconds ? "ms" : "us";
+            ImGui::Text("%-18s  %7s  %7s  %7s  %7s", "", "now", "p50", "p95", "p99");
             for (uint32_t i = 0; i < timeStamps.size(); i++)
             {
-                float value = m_state.bShowMilliseconds ? timeStamps[i].m_microseconds / 1000.0f : timeStamps[i].m_microseconds;
-                const char* pStrUnit = m_state.bShowMilliseconds ? "ms" : "us";
-                ImGui::Text("%-18s: %7.2f %s", timeStamps[i].m_label.c_str(), value, pStrUnit);
+                float p50, p95, p99;
+                if (m_timingHistory.GetPercentiles(timeStamps[i].m_label, &p50, &p95, &p99))
+                    ImGui::Text("%-18s: %7.2f  %7.2f  %7.2f  %7.2f %s", timeStamps[i].m_label.c_str(), timeStamps[i].m_microseconds / unit, p50 / unit, p95 / unit, p99 / unit, pStrUnit);
+                else
+                    ImGui::Text("%-18s: %7.2f %s", timeStamps[i].m_label.c_str(), timeStamps[i].m_microseconds / unit, pStrUnit);
+            }
+
+            ImGui::Spacing();
+            if (!m_timingHistory.IsTracing())
+            {
+                if (ImGui::Button("Record trace"))
+                    m_timingHistory.StartTrace();
             }
+            else
+            {
+                std::string stopText = format("Save trace (%d frames)", (int)m_timingHistory.GetTraceFrameCount());
+                if (ImGui::Button(stopText.c_str()))
+                    m_timingHistory.StopTrace(m_traceFilename);
+            }
+            ImGui::SameLine();
+            ImGui::Text("%s", m_traceFilename.c_str());
+        }
+
+        const std::vector<FSR_Filter::PassStatistics> &passStatistics = m_Node->GetPassStatistics();
+        if (m_state.m_nUpscaleType != 2 && !passStatistics.empty() && ImGui::CollapsingHeader("FSR pipeline statistics"))
+        {
+            for (const FSR_Filter::PassStatistics &pass : passStatistics)
+                ImGui::Text("%-18s: %.2fM invocations", pass.label.c_str(), pass.invocations / 1000000.0f);
         }
         ImGui::End(); // PROFILER
     }
@@ -883,7 +1156,17 @@ void FSRSample::OnRender()
     ImGUI_UpdateIO();
     ImGui::NewFrame();
 
-    if (m_loadingScene)
+    if (!m_loadingScene)
+        m_timingHistory.OnFrame(m_Node->GetTimingValues(), (float)m_deltaTime);
+
+    if (m_loadingScene && m_pGltfParsing)
+    {
+        // stage 0 just shows the progress bar
+        m_Node->LoadScene(NULL, 0);
+        if (m_gltfParse.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+            OnSceneParsed();
+    }
+    else if (m_loadingScene)
     {
         // the scene loads in chunks, that way we can show a progress bar
         static int loadingStage = 0;
@@ -892,6 +1175,29 @@ void FSRSample::OnRender()
         {
             m_time = 0;
             m_loadingScene = false;
+            // Cold startup ends with the first scene load, this frame is the first to render it
+            if (m_timeToFirstFrame == 0.0f)
+            {
+                m_timeToFirstFrame = (float)(MillisecondsNow() - m_startTime);
+                Trace(format("Startup: %.1f ms to the first frame, %.1f ms of it creating the renderer\n", m_timeToFirstFrame, m_Node->GetCreateTime()));
+            }
+            if (m_sweeping)
+                ApplySweepCell();
+        }
+    }
+    else if (m_pGltfLoader && m_state.bIsBenchmarking && m_sweeping)
+    {
+        // The sweep keeps the camera and the time still so every cell renders the same frame
+        if (m_sweep.OnFrame(m_Node->GetTimingValues(), m_Node->GetPassStatistics()))
+        {
+            if (m_sweep.IsDone())
+            {
+                m_sweep.WriteResults();
+                m_sweeping = false;
+                PostQuitMessage(0);
+            }
+            else
+                ApplySweepCell();
         }
     }
     else if (m_pGltfLoader && m_state.bIsBenchmarking)
@@ -915,6 +1221,9 @@ void FSRSample::OnRender()
             m_time += (float)m_deltaTime / 1000.0f;
     }
 
+    if (m_state.bDynamicResolution && m_state.m_nUpscaleType != 2 && !m_loadingScene)
+        UpdateDynamicResolution();
+
 
     // Animate and transform the scene
     //
@@ -930,8 +1239,9 @@ void FSRSample::OnRender()
     //
     m_Node->OnRender(m_Width, m_Height, &m_state, &m_swapChain);
 
-	// Framework will handle Present and some other end of frame logic
-	EndFrame();
+	// Framework will handle Present and some other end of frame logic, with the hidden window there is nothing to present
+    if (!m_state.bHiddenWindow)
+        EndFrame();
 }
 
 
@@ -947,6 +1257,10 @@ int WINAPI WinMain(HINSTANCE hInstance,
 {
     LPCSTR Name = "FidelityFX Super Resolution 1.0.2";
 
+    // The framework shows the window with nCmdShow right after creating it, so the hidden window has to be asked for here.
+    if (FSRSample::IsHiddenWindowRequested(lpCmdLine))
+        nCmdShow = SW_HIDE;
+
     // create new Vulkan sample
     return RunFramework(hInstance, lpCmdLine, nCmdShow, new FSRSample(Name));
 }
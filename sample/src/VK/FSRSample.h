@@ -19,6 +19,10 @@
 #pragma once
 
 #include "SampleRenderer.h"
+#include <future>
+#include "DynamicResolution.h"
+#include "BenchmarkSweep.h"
+#include "TimingHistory.h"
 
 //
 // This is the main class, it manages the state of the sample and does all the high level work without touching the GPU directly.
@@ -40,6 +44,8 @@ class FSRSample : public FrameworkWindows
 public:
     FSRSample(LPCSTR name);
     void OnParseCommandLine(LPSTR lpCmdLine, uint32_t* pWidth, uint32_t* pHeight) override;
+    // Peeks at the command line and the config file for the hidden window before the framework creates and shows it.
+    static bool IsHiddenWindowRequested(LPSTR lpCmdLine);
     void OnCreate() override;
     void OnDestroy() override;
     void OnRender() override;
@@ -47,13 +53,19 @@ public:
     
     void BuildUI();
     void LoadScene(int sceneIndex);
+    void OnSceneParsed();
+    // Waits for the glTF being parsed on the worker, if any, and throws it away.
+    void CancelSceneParse();
     
     void OnUpdate();
     void OnResize(bool resizeRender) override;
+    void OnRenderResolutionChanged();
     void OnUpdateDisplay() override {}
 
     void HandleInput(const ImGuiIO& io);
     void UpdateCamera(Camera& cam, const ImGuiIO& io);
+    void UpdateDynamicResolution();
+    void ApplySweepCell();
     
 private:
     bool RefreshRenderResolution()
@@ -88,11 +100,41 @@ private:
             m_state.renderHeight = uint32_t(m_Height / r);
         }
 
+        // With dynamic resolution the targets are allocated at display size once, the preset is only where the controller starts from.
+        if (m_state.bDynamicResolution && m_state.m_nUpscaleType != 2)
+        {
+            m_state.renderTargetWidth = m_Width;
+            m_state.renderTargetHeight = m_Height;
+            if (m_Width)
+                m_dynamicResolution.Reset((float)m_state.renderWidth / m_Width);
+        }
+        // TAA and native rendering need targets of the exact size. So do benchmark runs: with a bigger target the G-buffer clear,
+        // downsample and bloom would be timed at the size class instead of the resolution under test.
+        else if (m_state.bUseTAA || m_state.m_nUpscaleType == 2 || m_state.bIsBenchmarking)
+        {
+            m_state.renderTargetWidth = m_state.renderWidth;
+            m_state.renderTargetHeight = m_state.renderHeight;
+        }
+        // Otherwise the targets are allocated for a size class and rendered into at the requested size.
+        // All the presets fit the Ultra Quality one, so switching between them only moves the viewport.
+        else
+        {
+            uint32_t classWidth = uint32_t(m_Width / 1.3f);
+            uint32_t classHeight = uint32_t(m_Height / 1.3f);
+            bool fits = (m_state.renderWidth <= classWidth) && (m_state.renderHeight <= classHeight);
+            m_state.renderTargetWidth = fits ? classWidth : m_Width;
+            m_state.renderTargetHeight = fits ? classHeight : m_Height;
+        }
+
         return (rW != m_state.renderWidth) || (rH != m_state.renderHeight);
     }
 
     GLTFCommon                 *m_pGltfLoader = NULL;
     bool                        m_loadingScene = false;
+    // The glTF being parsed on a worker, it becomes m_pGltfLoader in OnSceneParsed()
+    GLTFCommon                 *m_pGltfParsing = NULL;
+    std::future<bool>           m_gltfParse;
+    int                         m_parsingScene = 0;
 
     SampleRenderer             *m_Node = NULL;
     State						m_state;
@@ -113,7 +155,20 @@ private:
 
     bool                        m_bPlay;
     bool                        m_bGlsl = true;
+    bool                        m_bParallelCreate = true;
+    // Cold startup, from OnCreate() to the end of the first scene load.
+    double                      m_startTime = 0.0;
+    float                       m_timeToFirstFrame = 0.0f;
     float mipBias[5];
 	int	m_nUpscaleRatio = 1;
 	float	m_fUpscaleRatio = 1.5f;
+    DynamicResolution           m_dynamicResolution;
+    BenchmarkSweep              m_sweep;
+    bool                        m_sweeping = false;
+    // Last OnRenderResolutionChanged(), flush included.
+    float                       m_resolutionChangeTime = 0.0f;
+    bool                        m_resolutionChangeReused = false;
+    TimingHistory               m_timingHistory;
+    // Where the profiler's trace goes, a non empty "traceFilename" in the globals also records from the start until exit.
+    std::string                 m_traceFilename = "FSRTrace.json";
 };
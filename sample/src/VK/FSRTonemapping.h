@@ -36,6 +36,8 @@ class FSRToneMapping : public ToneMapping
             pToneMapping->hdr = (hdr ? 1 : 0);
             pToneMapping->width = pState->renderWidth;
             pToneMapping->height = pState->renderHeight;
+            pToneMapping->uvScaleX = (float)pState->renderWidth / pState->renderTargetWidth;
+            pToneMapping->uvScaleY = (float)pState->renderHeight / pState->renderTargetHeight;
             static int frame = 0;
             frame = (frame + 1) % 8;
             pToneMapping->frame = frame;
@@ -55,5 +57,5 @@ class FSRToneMapping : public ToneMapping
 		}
 
     protected:
-        struct FSRToneMappingConsts { float exposure; int toneMapper; int width; int height; int hdr; int frame; };
+        struct FSRToneMappingConsts { float exposure; int toneMapper; int width; int height; int hdr; int frame; float uvScaleX; float uvScaleY; };
 };
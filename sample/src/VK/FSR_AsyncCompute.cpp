@@ -0,0 +1,228 @@
+// FidelityFX Super Resolution Sample
+//
+// Copyright (c) 2021 Advanced Micro Devices, Inc. All rights reserved.
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "stdafx.h"
+#include "FSR_AsyncCompute.h"
+
+void FSR_AsyncCompute::OnCreate(Device* pDevice, uint32_t numberOfBackBuffers)
+{
+	m_pDevice = pDevice;
+	m_numberOfBackBuffers = numberOfBackBuffers;
+	m_graphicsFamily = pDevice->GetGraphicsQueueFamilyIndex();
+	m_computeFamily = pDevice->GetComputeQueueFamilyIndex();
+	m_computeQueue = pDevice->GetComputeQueue();
+	m_supported = (m_computeFamily != m_graphicsFamily) && (m_computeQueue != VK_NULL_HANDLE);
+	if (!m_supported)
+		return;
+
+	uint32_t familyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(pDevice->GetPhysicalDevice(), &familyCount, NULL);
+	std::vector<VkQueueFamilyProperties> families(familyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(pDevice->GetPhysicalDevice(), &familyCount, families.data());
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(pDevice->GetPhysicalDevice(), &properties);
+	m_timestamps = families[m_graphicsFamily].timestampValidBits != 0 && families[m_computeFamily].timestampValidBits != 0;
+	m_timestampPeriod = properties.limits.timestampPeriod;
+
+	m_commandPools.resize(numberOfBackBuffers);
+	m_commandBuffers.resize(numberOfBackBuffers);
+	m_slotAsync.assign(numberOfBackBuffers, false);
+	for (uint32_t i = 0; i < numberOfBackBuffers; i++)
+	{
+		VkCommandPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		poolInfo.queueFamilyIndex = m_computeFamily;
+		VkResult res = vkCreateCommandPool(pDevice->GetDevice(), &poolInfo, NULL, &m_commandPools[i]);
+		assert(res == VK_SUCCESS);
+
+		VkCommandBufferAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.commandPool = m_commandPools[i];
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandBufferCount = 1;
+		res = vkAllocateCommandBuffers(pDevice->GetDevice(), &allocInfo, &m_commandBuffers[i]);
+		assert(res == VK_SUCCESS);
+	}
+
+	VkSemaphoreCreateInfo semaphoreInfo = {};
+	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	VkResult res = vkCreateSemaphore(pDevice->GetDevice(), &semaphoreInfo, NULL, &m_tonemapDone);
+	assert(res == VK_SUCCESS);
+	res = vkCreateSemaphore(pDevice->GetDevice(), &semaphoreInfo, NULL, &m_upscaleDone);
+	assert(res == VK_SUCCESS);
+
+	if (m_timestamps)
+	{
+		VkQueryPoolCreateInfo queryInfo = {};
+		queryInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		queryInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		queryInfo.queryCount = QUERY_COUNT * numberOfBackBuffers;
+		res = vkCreateQueryPool(pDevice->GetDevice(), &queryInfo, NULL, &m_queryPool);
+		assert(res == VK_SUCCESS);
+	}
+}
+
+void FSR_AsyncCompute::OnDestroy()
+{
+	if (!m_supported)
+		return;
+	VkDevice device = m_pDevice->GetDevice();
+	if (m_queryPool != VK_NULL_HANDLE)
+		vkDestroyQueryPool(device, m_queryPool, NULL);
+	m_queryPool = VK_NULL_HANDLE;
+	vkDestroySemaphore(device, m_tonemapDone, NULL);
+	vkDestroySemaphore(device, m_upscaleDone, NULL);
+	m_tonemapDone = VK_NULL_HANDLE;
+	m_upscaleDone = VK_NULL_HANDLE;
+	for (uint32_t i = 0; i < m_commandPools.size(); i++)
+		vkDestroyCommandPool(device, m_commandPools[i], NULL);
+	m_commandPools.clear();
+	m_commandBuffers.clear();
+	m_slotAsync.clear();
+	m_supported = false;
+}
+
+void FSR_AsyncCompute::OnBeginFrame(VkCommandBuffer cmd_buf, GPUTimestamps* pTimer)
+{
+	if (!m_supported)
+		return;
+	m_frame++;
+	if (!m_timestamps)
+		return;
+
+	// The slot was last used m_numberOfBackBuffers frames ago, its results are usually there already. If not, this frame is not measured.
+	uint32_t slot = m_frame % m_numberOfBackBuffers;
+	uint32_t firstQuery = slot * QUERY_COUNT;
+	if (m_slotAsync[slot])
+	{
+		uint64_t ticks[QUERY_COUNT];
+		VkResult res = vkGetQueryPoolResults(m_pDevice->GetDevice(), m_queryPool, firstQuery, QUERY_COUNT, sizeof(ticks), ticks, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+		if (res == VK_SUCCESS)
+		{
+			m_stats.upscale = (float)(ticks[QUERY_UPSCALE_END] - ticks[QUERY_UPSCALE_BEGIN]) * m_timestampPeriod / 1000.0f;
+			m_stats.available = true;
+			pTimer->GetTimeStampUser({ "FSR async upscale (overlap not measured)", m_stats.upscale });
+		}
+	} else
+		m_stats.available = false;
+	m_slotAsync[slot] = false;
+
+	vkCmdResetQueryPool(cmd_buf, m_queryPool, firstQuery, QUERY_COUNT);
+}
+
+void FSR_AsyncCompute::QueueTransfer(VkCommandBuffer cmd_buf, bool release, bool toCompute, VkImage image, VkImageLayout layout, VkPipelineStageFlags stages, VkAccessFlags access)
+{
+	// Release only needs the source half of the dependency and acquire only the destination one, the semaphore orders the two.
+	VkImageMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.srcAccessMask = release ? access : 0;
+	barrier.dstAccessMask = release ? 0 : access;
+	barrier.oldLayout = layout;
+	barrier.newLayout = layout;
+	barrier.srcQueueFamilyIndex = toCompute ? m_graphicsFamily : m_computeFamily;
+	barrier.dstQueueFamilyIndex = toCompute ? m_computeFamily : m_graphicsFamily;
+	barrier.image = image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.baseMipLevel = 0;
+	barrier.subresourceRange.levelCount = 1;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+	// The acquire waits on the same stages it unblocks, which chains it to the semaphore wait of the submission.
+	vkCmdPipelineBarrier(cmd_buf, stages, release ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : stages, 0, 0, NULL, 0, NULL, 1, &barrier);
+}
+
+void FSR_AsyncCompute::SubmitGraphics(VkCommandBuffer cmd_buf, VkImage input, VkImage output)
+{
+	// The input was just written by the tonemapping render pass, the output only went through the frame start barrier.
+	QueueTransfer(cmd_buf, true, true, input, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
+	QueueTransfer(cmd_buf, true, true, output, VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_ACCESS_MEMORY_WRITE_BIT);
+
+	VkResult res = vkEndCommandBuffer(cmd_buf);
+	assert(res == VK_SUCCESS);
+
+	VkSubmitInfo submit_info = {};
+	submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submit_info.commandBufferCount = 1;
+	submit_info.pCommandBuffers = &cmd_buf;
+	submit_info.signalSemaphoreCount = 1;
+	submit_info.pSignalSemaphores = &m_tonemapDone;
+	res = vkQueueSubmit(m_pDevice->GetGraphicsQueue(), 1, &submit_info, VK_NULL_HANDLE);
+	assert(res == VK_SUCCESS);
+}
+
+VkCommandBuffer FSR_AsyncCompute::BeginUpscale(VkImage input, VkImage output)
+{
+	// Called after WaitForSwapChain(), so the last frame that used this slot, and the upscale it waited on, are done.
+	uint32_t slot = m_frame % m_numberOfBackBuffers;
+	VkResult res = vkResetCommandPool(m_pDevice->GetDevice(), m_commandPools[slot], 0);
+	assert(res == VK_SUCCESS);
+
+	VkCommandBuffer cmd_buf = m_commandBuffers[slot];
+	VkCommandBufferBeginInfo cmd_buf_info = {};
+	cmd_buf_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	cmd_buf_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	res = vkBeginCommandBuffer(cmd_buf, &cmd_buf_info);
+	assert(res == VK_SUCCESS);
+
+	QueueTransfer(cmd_buf, false, true, input, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+	QueueTransfer(cmd_buf, false, true, output, VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+	// Written at the stage the semaphore wait blocks, a top of pipe stamp would land before the tonemapping is even done.
+	if (m_timestamps)
+		vkCmdWriteTimestamp(cmd_buf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, m_queryPool, slot * QUERY_COUNT + QUERY_UPSCALE_BEGIN);
+	return cmd_buf;
+}
+
+void FSR_AsyncCompute::SubmitUpscale(VkCommandBuffer cmd_buf, VkImage input, VkImage output)
+{
+	uint32_t slot = m_frame % m_numberOfBackBuffers;
+	// The fused comparison copies the output out with a transfer, so release from that stage too.
+	QueueTransfer(cmd_buf, true, false, input, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0);
+	QueueTransfer(cmd_buf, true, false, output, VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+	if (m_timestamps)
+	{
+		vkCmdWriteTimestamp(cmd_buf, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_queryPool, slot * QUERY_COUNT + QUERY_UPSCALE_END);
+		m_slotAsync[slot] = true;
+	}
+
+	VkResult res = vkEndCommandBuffer(cmd_buf);
+	assert(res == VK_SUCCESS);
+
+	// The acquire barriers wait on the compute stage, so that is all the semaphore has to hold back.
+	VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	VkSubmitInfo submit_info = {};
+	submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submit_info.waitSemaphoreCount = 1;
+	submit_info.pWaitSemaphores = &m_tonemapDone;
+	submit_info.pWaitDstStageMask = &waitStage;
+	submit_info.commandBufferCount = 1;
+	submit_info.pCommandBuffers = &cmd_buf;
+	submit_info.signalSemaphoreCount = 1;
+	submit_info.pSignalSemaphores = &m_upscaleDone;
+	res = vkQueueSubmit(m_computeQueue, 1, &submit_info, VK_NULL_HANDLE);
+	assert(res == VK_SUCCESS);
+}
+
+void FSR_AsyncCompute::AcquireOnGraphics(VkCommandBuffer cmd_buf, VkImage input, VkImage output)
+{
+	// Same destination the filter hands the output to on the graphics queue: the magnifier samples it and the UI draws into it.
+	QueueTransfer(cmd_buf, false, false, input, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+	QueueTransfer(cmd_buf, false, false, output, VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+		VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT);
+}
@@ -0,0 +1,96 @@
+// FidelityFX Super Resolution Sample
+//
+// Copyright (c) 2021 Advanced Micro Devices, Inc. All rights reserved.
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+// Moves the FSR passes to a dedicated compute queue.
+// With it enabled a frame is submitted as
+//   graphics: shadows, G-buffer, post   (cmdBuf1)
+//   graphics: tonemapping               -> signals m_tonemapDone
+//   compute:  EASU / RCAS               waits m_tonemapDone, signals m_upscaleDone
+//   graphics: magnifier, UI, present    waits m_upscaleDone
+// Each wait only blocks the stages that touch the images, but the final graphics submission still sits in front of the next frame's
+// cmdBuf1 on the graphics queue, so nothing guarantees the upscale overlaps other work. Only the upscale itself is timed: timestamps
+// written on two queues can't be compared without VK_EXT_calibrated_timestamps, which the framework doesn't enable. The UI and the
+// profiler say that the overlap is not measured rather than report one.
+// The images cross queue families, so the input and output get release / acquire barriers around the compute work.
+class FSR_AsyncCompute
+{
+public:
+	void OnCreate(Device* pDevice, uint32_t numberOfBackBuffers);
+	void OnDestroy();
+
+	// False when the device has no compute family separate from the graphics one, the caller then stays on the graphics queue.
+	bool IsSupported() const { return m_supported; }
+	// Timestamps written on the compute queue are only valid if its family has timestamp bits.
+	bool HasTimestamps() const { return m_timestamps; }
+
+	// Reads back the queries of the frame that last used this slot and resets them, in cmdBuf1.
+	void OnBeginFrame(VkCommandBuffer cmd_buf, GPUTimestamps* pTimer);
+
+	// Graphics side: hands input and output over and submits everything recorded so far.
+	void SubmitGraphics(VkCommandBuffer cmd_buf, VkImage input, VkImage output);
+	// Compute side: returns a recording command buffer with both images already acquired.
+	VkCommandBuffer BeginUpscale(VkImage input, VkImage output);
+	// Releases input and output back to graphics and submits the compute work.
+	void SubmitUpscale(VkCommandBuffer cmd_buf, VkImage input, VkImage output);
+	// Graphics side again: acquires the images at the start of the command buffer that draws the UI and presents.
+	void AcquireOnGraphics(VkCommandBuffer cmd_buf, VkImage input, VkImage output);
+	// To be waited on by the final graphics submission at GetUpscaleDoneWaitStages(), the stages the acquire barriers unblock.
+	VkSemaphore GetUpscaleDoneSemaphore() const { return m_upscaleDone; }
+	static VkPipelineStageFlags GetUpscaleDoneWaitStages() { return VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT; }
+
+	// Last measured frame, in microseconds, from the end of the semaphore wait to the release barriers.
+	struct Stats
+	{
+		bool                        available = false;
+		float                       upscale = 0.0f;
+	};
+	const Stats& GetStats() const { return m_stats; }
+
+private:
+	enum Query
+	{
+		QUERY_UPSCALE_BEGIN,
+		QUERY_UPSCALE_END,
+		QUERY_COUNT
+	};
+	void QueueTransfer(VkCommandBuffer cmd_buf, bool release, bool toCompute, VkImage image, VkImageLayout layout, VkPipelineStageFlags stages, VkAccessFlags access);
+
+	Device                          *m_pDevice = NULL;
+	bool                            m_supported = false;
+	bool                            m_timestamps = false;
+	uint32_t                        m_graphicsFamily = 0;
+	uint32_t                        m_computeFamily = 0;
+	VkQueue                         m_computeQueue = VK_NULL_HANDLE;
+	float                           m_timestampPeriod = 1.0f;
+
+	// One pool per back buffer, reset when the slot comes around again. The swapchain fence of that frame covers the compute work
+	// since the final graphics submission waits on it.
+	uint32_t                        m_numberOfBackBuffers = 0;
+	uint32_t                        m_frame = 0;
+	std::vector<VkCommandPool>      m_commandPools;
+	std::vector<VkCommandBuffer>    m_commandBuffers;
+	std::vector<bool>               m_slotAsync;
+	VkQueryPool                     m_queryPool = VK_NULL_HANDLE;
+
+	VkSemaphore                     m_tonemapDone = VK_NULL_HANDLE;
+	VkSemaphore                     m_upscaleDone = VK_NULL_HANDLE;
+	Stats                           m_stats;
+};
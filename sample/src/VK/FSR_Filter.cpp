@@ -20,25 +20,15 @@
 #include "stdafx.h"
 #include "FSR_Filter.h"
 #include "SampleRenderer.h"
+#include "TransientAllocator.h"
+#include <algorithm>
 
 // CAS
 #define A_CPU
 #include "ffx_a.h"
 #include "ffx_fsr1.h"
 
-#include <DirectXMath.h>
-using namespace DirectX;
-
-struct FSRConstants
-{
-	XMUINT4 Const0;
-	XMUINT4 Const1;
-	XMUINT4 Const2;
-	XMUINT4 Const3;
-	XMUINT4 Sample;
-};
-
-void FSR_Filter::OnCreate(Device* pDevice, ResourceViewHeaps* pResourceViewHeaps, DynamicBufferRing * pConstantBufferRing, bool glsl)
+void FSR_Filter::OnCreate(Device* pDevice, ResourceViewHeaps* pResourceViewHeaps, bool glsl, AsyncPool* pAsyncPool)
 {
 	m_pDevice = pDevice;
 	m_pResourceViewHeaps = pResourceViewHeaps;
@@ -58,38 +48,51 @@ void FSR_Filter::OnCreate(Device* pDevice, ResourceViewHeaps* pResourceViewHeaps
 		assert(res == VK_SUCCESS);
 	}
 	{
-		std::vector<VkDescriptorSetLayoutBinding> layoutBindings(4);
-		layoutBindings[0].binding = 0;
-		layoutBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+		// Binding 0 used to be the constant buffer, the constants are push constants now.
+		std::vector<VkDescriptorSetLayoutBinding> layoutBindings(3);
+		layoutBindings[0].binding = 1;
+		layoutBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
 		layoutBindings[0].descriptorCount = 1;
 		layoutBindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
 		layoutBindings[0].pImmutableSamplers = NULL;
 
-		layoutBindings[1].binding = 1;
-		layoutBindings[1].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+		layoutBindings[1].binding = 2;
+		layoutBindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
 		layoutBindings[1].descriptorCount = 1;
 		layoutBindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
 		layoutBindings[1].pImmutableSamplers = NULL;
 
-		layoutBindings[2].binding = 2;
-		layoutBindings[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		layoutBindings[2].binding = 3;
+		layoutBindings[2].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
 		layoutBindings[2].descriptorCount = 1;
 		layoutBindings[2].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-		layoutBindings[2].pImmutableSamplers = NULL;
-
-		layoutBindings[3].binding = 3;
-		layoutBindings[3].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
-		layoutBindings[3].descriptorCount = 1;
-		layoutBindings[3].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-		layoutBindings[3].pImmutableSamplers = &m_sampler;
+		layoutBindings[2].pImmutableSamplers = &m_sampler;
 
 		pResourceViewHeaps->CreateDescriptorSetLayoutAndAllocDescriptorSet(&layoutBindings, &m_descriptorSetLayout, &m_easuDescriptorSet);
-		pConstantBufferRing->SetDescriptorSet(0, sizeof(uint32_t) * 16, m_easuDescriptorSet);
+		pResourceViewHeaps->AllocDescriptor(m_descriptorSetLayout, &m_easuToIntermediaryDescriptorSet);
 		pResourceViewHeaps->AllocDescriptor(m_descriptorSetLayout, &m_rcasDescriptorSet);
-		pConstantBufferRing->SetDescriptorSet(0, sizeof(uint32_t) * 16, m_rcasDescriptorSet);
+		pResourceViewHeaps->AllocDescriptor(m_descriptorSetLayout, &m_rcasToCompareDescriptorSet);
+		pResourceViewHeaps->AllocDescriptor(m_descriptorSetLayout, &m_easuToCompareDescriptorSet);
+	}
+	{
+		VkPushConstantRange pushConstantRange = {};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(FSRConstants);
+
+		VkPipelineLayoutCreateInfo info = {};
+		info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		info.setLayoutCount = 1;
+		info.pSetLayouts = &m_descriptorSetLayout;
+		info.pushConstantRangeCount = 1;
+		info.pPushConstantRanges = &pushConstantRange;
+		VkResult res = vkCreatePipelineLayout(pDevice->GetDevice(), &info, NULL, &m_pipelineLayout);
+		assert(res == VK_SUCCESS);
 	}
 
-	char *source, *flags;
+	// Both modules are kept when the device has fp16, so State::bUseFp16 can switch to the slow fallback at runtime.
+	m_fp16 = pDevice->IsFp16Supported();
+	const char *source, *flags;
 	if (glsl)
 	{
 		source = "FSR_Pass.glsl";
@@ -99,28 +102,236 @@ void FSR_Filter::OnCreate(Device* pDevice, ResourceViewHeaps* pResourceViewHeaps
 		source = "FSR_Pass.hlsl";
 		flags = "-T cs_6_2 -enable-16bit-types";
 	}
+	// One module per precision, the passes are specialization constants of it. The packed EASU has an fp16 module of its own,
+	// so FsrEasuHx2 stays out of the default passes and a failure to build it only takes away the option.
+	// The build emits them as SPIR-V (see CMakeLists.txt), compiling from source is only the fallback when a binary is missing.
+	// Each precision is a job on the pool when there is one: its modules, then their pipelines. The pipeline cache is internally synchronized.
+	// Nothing reads the pipelines before the caller flushes the pool.
+	CreatePipelineCache();
+	for (int fp16 = 0; fp16 <= (m_fp16 ? 1 : 0); fp16++)
+	{
+		ExecAsyncIfThereIsAPool(pAsyncPool, [this, fp16, glsl, source, flags]()
+		{
+			std::string spirv = std::string(glsl ? "FSR_Pass_glsl" : "FSR_Pass_hlsl") + (fp16 ? "_fp16" : "_fp32");
+			bool res = CreateShader((spirv + ".spv").c_str(), source, flags, fp16 != 0, false, &m_computeShader[fp16]);
+			assert(res);
+
+			for (int pass = 0; pass < FSR_PASS_COUNT; pass++)
+			{
+				if (pass == FSR_PASS_RCAS_HX2 || pass == FSR_PASS_EASU_HX2)
+					continue;
+				CreatePipeline(fp16 != 0, (FSRPass)pass, false, &m_pipelines[fp16][pass][0]);
+				CreatePipeline(fp16 != 0, (FSRPass)pass, true, &m_pipelines[fp16][pass][1]);
+				if (pass == FSR_PASS_EASU || pass == FSR_PASS_FUSED)
+				{
+					CreatePipeline(fp16 != 0, (FSRPass)pass, false, &m_clampPipelines[fp16][pass][0], 0, true);
+					CreatePipeline(fp16 != 0, (FSRPass)pass, true, &m_clampPipelines[fp16][pass][1], 0, true);
+				}
+			}
+			// The packed passes need fp16, the fp32 module would just run the regular RCAS for them.
+			if (fp16)
+			{
+				for (uint32_t post = 0; post < FSR_POST_COUNT; post++)
+				{
+					CreatePipeline(true, FSR_PASS_RCAS_HX2, false, &m_rcasHx2Pipelines[0][post], post);
+					CreatePipeline(true, FSR_PASS_RCAS_HX2, true, &m_rcasHx2Pipelines[1][post], post);
+				}
+				if (CreateShader((spirv + "_easuhx2.spv").c_str(), source, flags, true, true, &m_easuHx2Shader))
+				{
+					CreatePipeline(true, FSR_PASS_EASU_HX2, false, &m_pipelines[1][FSR_PASS_EASU_HX2][0]);
+					CreatePipeline(true, FSR_PASS_EASU_HX2, true, &m_pipelines[1][FSR_PASS_EASU_HX2][1]);
+					CreatePipeline(true, FSR_PASS_EASU_HX2, false, &m_clampPipelines[1][FSR_PASS_EASU_HX2][0], 0, true);
+					CreatePipeline(true, FSR_PASS_EASU_HX2, true, &m_clampPipelines[1][FSR_PASS_EASU_HX2][1], 0, true);
+				}
+			}
+		});
+	}
+
+	// Cauldron enables pipelineStatisticsQuery on the device, the GPU still has to support it.
+	VkPhysicalDeviceFeatures features;
+	vkGetPhysicalDeviceFeatures(pDevice->GetPhysicalDevice(), &features);
+	if (features.pipelineStatisticsQuery)
+	{
+		VkQueryPoolCreateInfo info = {};
+		info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		info.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+		info.queryCount = backBufferCount * s_statsPerFrame;
+		info.pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+		VkResult res = vkCreateQueryPool(pDevice->GetDevice(), &info, NULL, &m_statsQueryPool);
+		assert(res == VK_SUCCESS);
+	}
+	m_statsLabels.assign(backBufferCount, std::vector<std::string>());
+	m_passStatistics.clear();
+
+	m_constsValid = false;
+}
+
+bool FSR_Filter::CreateShader(const char* spirv, const char* source, const char* flags, bool fp16, bool easuHx2, VkPipelineShaderStageCreateInfo* pShader)
+{
+	if (LoadPrecompiledShader(spirv, pShader))
+		return true;
 	DefineList defines;
-	if (pDevice->IsFp16Supported())
-		defines["SAMPLE_SLOW_FALLBACK"] = "0";
+	defines["SAMPLE_SLOW_FALLBACK"] = (fp16 ? "0" : "1");
+	defines["SAMPLE_EASU_HX2"] = (easuHx2 ? "1" : "0");
+	defines["WIDTH"] = "64";
+	defines["HEIGHT"] = "1";
+	defines["DEPTH"] = "1";
+	return VKCompileFromFile(m_pDevice->GetDevice(), VK_SHADER_STAGE_COMPUTE_BIT, source, "main", flags, &defines, pShader) == VK_SUCCESS;
+}
+
+bool FSR_Filter::LoadPrecompiledShader(const char* name, VkPipelineShaderStageCreateInfo* pShader)
+{
+	std::ifstream file(GetShaderCompilerLibDir() + "/" + name, std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+		return false;
+	size_t size = (size_t)file.tellg();
+	if (size == 0 || (size % sizeof(uint32_t)) != 0)
+		return false;
+	std::vector<uint32_t> code(size / sizeof(uint32_t));
+	file.seekg(0);
+	file.read(reinterpret_cast<char*>(code.data()), size);
+
+	VkShaderModuleCreateInfo moduleInfo = {};
+	moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	moduleInfo.codeSize = size;
+	moduleInfo.pCode = code.data();
+	VkShaderModule module;
+	if (vkCreateShaderModule(m_pDevice->GetDevice(), &moduleInfo, NULL, &module) != VK_SUCCESS)
+		return false;
+
+	*pShader = {};
+	pShader->sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pShader->stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pShader->module = module;
+	pShader->pName = "main";
+	return true;
+}
+
+// The FSR pipelines get their own cache, stored next to the shader cache and named after the pipelineCacheUUID of the device.
+// A file written by another driver or GPU is simply not picked up, so the cache starts cold instead of being rejected.
+void FSR_Filter::CreatePipelineCache()
+{
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(m_pDevice->GetPhysicalDevice(), &properties);
+
+	char uuid[VK_UUID_SIZE * 2 + 1] = {};
+	for (int i = 0; i < VK_UUID_SIZE; i++)
+		sprintf_s(&uuid[i * 2], 3, "%02x", properties.pipelineCacheUUID[i]);
+	m_pipelineCachePath = GetShaderCompilerCacheDir() + "/FSR_PipelineCache_" + uuid + ".bin";
+
+	std::vector<char> data;
+	std::ifstream file(m_pipelineCachePath, std::ios::binary | std::ios::ate);
+	if (file.is_open())
+	{
+		data.resize((size_t)file.tellg());
+		file.seekg(0);
+		file.read(data.data(), data.size());
+	}
+
+	// The driver validates the data too, checking the header here just keeps a truncated or foreign file out of it.
+	const size_t headerSize = 16 + VK_UUID_SIZE;
+	if (data.size() >= headerSize)
+	{
+		uint32_t header[4];
+		memcpy(header, data.data(), sizeof(header));
+		if (header[0] < headerSize || header[1] != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+			header[2] != properties.vendorID || header[3] != properties.deviceID ||
+			memcmp(data.data() + 16, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+			data.clear();
+	}
 	else
-		defines["SAMPLE_SLOW_FALLBACK"] = "1";
-	defines["SAMPLE_BILINEAR"] = "0";
-	defines["SAMPLE_RCAS"] = "0";
-	defines["SAMPLE_EASU"] = "1";
-	m_easu.OnCreate(pDevice, source, "main", flags, m_descriptorSetLayout, 64, 1, 1, &defines);
-	defines["SAMPLE_EASU"] = "0";
-	defines["SAMPLE_RCAS"] = "1";
-	m_rcas.OnCreate(pDevice, source, "main", flags, m_descriptorSetLayout, 64, 1, 1, &defines);
-	defines["SAMPLE_RCAS"] = "0";
-	defines["SAMPLE_BILINEAR"] = "1";
-	m_bilinear.OnCreate(pDevice, source, "main", flags, m_descriptorSetLayout, 64, 1, 1, &defines);
-	defines["SAMPLE_BILINEAR"] = "0";
+		data.clear();
+
+	VkPipelineCacheCreateInfo info = {};
+	info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	info.initialDataSize = data.size();
+	info.pInitialData = data.empty() ? NULL : data.data();
+	VkResult res = vkCreatePipelineCache(m_pDevice->GetDevice(), &info, NULL, &m_pipelineCache);
+	assert(res == VK_SUCCESS);
+}
+
+void FSR_Filter::SavePipelineCache()
+{
+	size_t size = 0;
+	VkResult res = vkGetPipelineCacheData(m_pDevice->GetDevice(), m_pipelineCache, &size, NULL);
+	if (res != VK_SUCCESS || size == 0)
+		return;
+	std::vector<char> data(size);
+	res = vkGetPipelineCacheData(m_pDevice->GetDevice(), m_pipelineCache, &size, data.data());
+	if (res != VK_SUCCESS)
+		return;
+
+	std::ofstream file(m_pipelineCachePath, std::ios::binary | std::ios::trunc);
+	if (file.is_open())
+		file.write(data.data(), size);
+}
+
+void FSR_Filter::CreatePipeline(bool fp16, FSRPass pass, bool hdr, VkPipeline* pPipeline, uint32_t post, bool clampInput)
+{
+	struct
+	{
+		uint32_t pass;
+		VkBool32 hdr;
+		VkBool32 tepd;
+		VkBool32 lfga;
+		VkBool32 clampInput;
+	} specializationData = { (uint32_t)pass, hdr ? VK_TRUE : VK_FALSE, (post & FSR_POST_TEPD) ? VK_TRUE : VK_FALSE, (post & FSR_POST_LFGA) ? VK_TRUE : VK_FALSE, clampInput ? VK_TRUE : VK_FALSE };
+
+	VkSpecializationMapEntry specializationEntries[5] = {};
+	specializationEntries[0].constantID = 0;
+	specializationEntries[0].offset = offsetof(decltype(specializationData), pass);
+	specializationEntries[0].size = sizeof(uint32_t);
+	specializationEntries[1].constantID = 1;
+	specializationEntries[1].offset = offsetof(decltype(specializationData), hdr);
+	specializationEntries[1].size = sizeof(VkBool32);
+	specializationEntries[2].constantID = 2;
+	specializationEntries[2].offset = offsetof(decltype(specializationData), tepd);
+	specializationEntries[2].size = sizeof(VkBool32);
+	specializationEntries[3].constantID = 3;
+	specializationEntries[3].offset = offsetof(decltype(specializationData), lfga);
+	specializationEntries[3].size = sizeof(VkBool32);
+	specializationEntries[4].constantID = 4;
+	specializationEntries[4].offset = offsetof(decltype(specializationData), clampInput);
+	specializationEntries[4].size = sizeof(VkBool32);
+
+	VkSpecializationInfo specializationInfo = {};
+	specializationInfo.mapEntryCount = _countof(specializationEntries);
+	specializationInfo.pMapEntries = specializationEntries;
+	specializationInfo.dataSize = sizeof(specializationData);
+	specializationInfo.pData = &specializationData;
+
+	VkComputePipelineCreateInfo info = {};
+	info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	info.stage = (pass == FSR_PASS_EASU_HX2) ? m_easuHx2Shader : m_computeShader[fp16 ? 1 : 0];
+	info.stage.pSpecializationInfo = &specializationInfo;
+	info.layout = m_pipelineLayout;
+	VkResult res = vkCreateComputePipelines(m_pDevice->GetDevice(), m_pipelineCache, 1, &info, NULL, pPipeline);
+	assert(res == VK_SUCCESS);
+}
+
+void FSR_Filter::CreateIntermediary(TransientAllocator* pAllocator, int displayWidth, int displayHeight, bool hdr)
+{
+	VkImageCreateInfo info = {};
+	info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	info.imageType = VK_IMAGE_TYPE_2D;
+	info.format = (hdr ? VK_FORMAT_A2R10G10B10_UNORM_PACK32 : VK_FORMAT_R8G8B8A8_UNORM);
+	info.extent.width = displayWidth;
+	info.extent.height = displayHeight;
+	info.extent.depth = 1;
+	info.mipLevels = 1;
+	info.arrayLayers = 1;
+	info.samples = VK_SAMPLE_COUNT_1_BIT;
+	info.tiling = VK_IMAGE_TILING_OPTIMAL;
+	info.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+	info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	// Only alive between EASU and RCAS, the fused comparison included.
+	m_intermediary = pAllocator->CreateImage(info, TransientAllocator::PASS_EASU, TransientAllocator::PASS_RCAS, "FSR Intermediary");
 }
 
 void FSR_Filter::OnCreateWindowSizeDependentResources(Device* pDevice, VkImage input, VkImage output, VkFormat outputFormat, int displayWidth, int displayHeight, State* pState, bool hdr)
 {
 	VkFormat fmt = (hdr ? VK_FORMAT_A2R10G10B10_UNORM_PACK32 : VK_FORMAT_R8G8B8A8_UNORM);
-	m_intermediary.InitRenderTarget(pDevice, displayWidth, displayHeight, fmt, VK_SAMPLE_COUNT_1_BIT, (VkImageUsageFlags)(VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT), false, "FSR Intermediary");
 
 	VkImageViewCreateInfo info = {};
 	info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -134,219 +345,630 @@ void FSR_Filter::OnCreateWindowSizeDependentResources(Device* pDevice, VkImage i
 	info.subresourceRange.baseArrayLayer = 0;
 	VkResult res = vkCreateImageView(m_pDevice->GetDevice(), &info, NULL, &m_outputTextureUav);
 	assert(res == VK_SUCCESS);
-	info.image = m_intermediary.Resource();
+	info.image = m_intermediary;
 	info.format = fmt;
 	res = vkCreateImageView(m_pDevice->GetDevice(), &info, NULL, &m_intermediaryUav);
 	assert(res == VK_SUCCESS);
 	info.image = input;
 	res = vkCreateImageView(m_pDevice->GetDevice(), &info, NULL, &m_inputTextureSrv);
 	assert(res == VK_SUCCESS);
+
+	// The views only change here, so the sets for each path are written once instead of every frame.
+	// EASU-only and bilinear share the input to output set.
+	UpdateDescriptorSet(m_easuDescriptorSet, m_inputTextureSrv, m_outputTextureUav);
+	UpdateDescriptorSet(m_easuToIntermediaryDescriptorSet, m_inputTextureSrv, m_intermediaryUav);
+	UpdateDescriptorSet(m_rcasDescriptorSet, m_intermediaryUav, m_outputTextureUav);
+
+	m_inputState = ImageState();
+	m_inputState.image = input;
+	m_outputState = ImageState();
+	m_outputState.image = output;
+	m_intermediaryState = ImageState();
+	m_intermediaryState.image = m_intermediary;
+
+	m_displayWidth = displayWidth;
+	m_displayHeight = displayHeight;
+	m_outputFormat = outputFormat;
+}
+
+void FSR_Filter::UpdateDescriptorSet(VkDescriptorSet descriptorSet, VkImageView input, VkImageView output)
+{
+	VkDescriptorImageInfo ImgInfos[2] = {};
+	VkWriteDescriptorSet SetWrites[2] = {};
+
+	ImgInfos[0].sampler = VK_NULL_HANDLE;
+	ImgInfos[0].imageView = input;
+	ImgInfos[0].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	SetWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	SetWrites[0].dstSet = descriptorSet;
+	SetWrites[0].dstBinding = 1;
+	SetWrites[0].descriptorCount = 1;
+	SetWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+	SetWrites[0].pImageInfo = ImgInfos + 0;
+
+	// Dst img
+	ImgInfos[1].sampler = VK_NULL_HANDLE;
+	ImgInfos[1].imageView = output;
+	ImgInfos[1].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+	SetWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	SetWrites[1].dstSet = descriptorSet;
+	SetWrites[1].dstBinding = 2;
+	SetWrites[1].descriptorCount = 1;
+	SetWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	SetWrites[1].pImageInfo = ImgInfos + 1;
+
+	vkUpdateDescriptorSets(m_pDevice->GetDevice(), _countof(SetWrites), SetWrites, 0, 0);
+}
+
+static const VkAccessFlags s_writeAccess = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+// Queues a barrier when the image is not already usable as requested, barriers are batched until FlushBarriers().
+// Read after read in the same layout needs no barrier, the new readers are merged into the state instead.
+// 'discard' allows the transition to start from UNDEFINED, for images that are about to be fully overwritten.
+void FSR_Filter::Require(ImageState* pImage, VkImageLayout layout, VkPipelineStageFlags stages, VkAccessFlags access, bool discard)
+{
+	bool layoutChange = (pImage->layout != layout);
+	// Read or write after write, or write after read. Nothing recorded yet means the frame start barriers already cover it.
+	bool hazard = ((pImage->access & s_writeAccess) != 0) || ((pImage->access != 0) && ((access & s_writeAccess) != 0));
+	if (!layoutChange && !hazard)
+	{
+		pImage->stages |= stages;
+		pImage->access |= access;
+		return;
+	}
+
+	VkImageMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	// Only writes need to be made available, write after read just needs the execution dependency.
+	barrier.srcAccessMask = pImage->access & s_writeAccess;
+	barrier.dstAccessMask = access;
+	barrier.oldLayout = discard ? VK_IMAGE_LAYOUT_UNDEFINED : pImage->layout;
+	barrier.newLayout = layout;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = pImage->image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.baseMipLevel = 0;
+	barrier.subresourceRange.levelCount = 1;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+	m_pendingBarriers.push_back(barrier);
+	m_pendingSrcStages |= pImage->stages;
+	m_pendingDstStages |= stages;
+
+	pImage->layout = layout;
+	pImage->stages = stages;
+	pImage->access = access;
+}
+
+void FSR_Filter::FlushBarriers(VkCommandBuffer cmd_buf)
+{
+	if (m_pendingBarriers.empty())
+		return;
+	vkCmdPipelineBarrier(cmd_buf, m_pendingSrcStages, m_pendingDstStages, 0, 0, NULL, 0, NULL, (uint32_t)m_pendingBarriers.size(), m_pendingBarriers.data());
+	m_pendingBarriers.clear();
+	m_pendingSrcStages = 0;
+	m_pendingDstStages = 0;
 }
 
 void FSR_Filter::OnDestroyWindowSizeDependentResources()
 {
-	m_intermediary.OnDestroy();
+	m_intermediary = VK_NULL_HANDLE;
 	vkDestroyImageView(m_pDevice->GetDevice(), m_outputTextureUav, 0);
 	vkDestroyImageView(m_pDevice->GetDevice(), m_intermediaryUav, 0);
 	vkDestroyImageView(m_pDevice->GetDevice(), m_inputTextureSrv, 0);
+	DestroyCompareResources();
 }
 
 void FSR_Filter::OnDestroy()
 {
 	vkDestroySampler(m_pDevice->GetDevice(), m_sampler, nullptr);
-	m_easu.OnDestroy();
-	m_rcas.OnDestroy();
-	m_bilinear.OnDestroy();
+	for (int fp16 = 0; fp16 < 2; fp16++)
+	{
+		for (int pass = 0; pass < FSR_PASS_COUNT; pass++)
+		{
+			vkDestroyPipeline(m_pDevice->GetDevice(), m_pipelines[fp16][pass][0], nullptr);
+			vkDestroyPipeline(m_pDevice->GetDevice(), m_pipelines[fp16][pass][1], nullptr);
+			vkDestroyPipeline(m_pDevice->GetDevice(), m_clampPipelines[fp16][pass][0], nullptr);
+			vkDestroyPipeline(m_pDevice->GetDevice(), m_clampPipelines[fp16][pass][1], nullptr);
+		}
+		vkDestroyShaderModule(m_pDevice->GetDevice(), m_computeShader[fp16].module, nullptr);
+	}
+	vkDestroyShaderModule(m_pDevice->GetDevice(), m_easuHx2Shader.module, nullptr);
+	for (int post = 0; post < FSR_POST_COUNT; post++)
+	{
+		vkDestroyPipeline(m_pDevice->GetDevice(), m_rcasHx2Pipelines[0][post], nullptr);
+		vkDestroyPipeline(m_pDevice->GetDevice(), m_rcasHx2Pipelines[1][post], nullptr);
+	}
+	vkDestroyQueryPool(m_pDevice->GetDevice(), m_statsQueryPool, nullptr);
+	m_statsQueryPool = VK_NULL_HANDLE;
+	SavePipelineCache();
+	vkDestroyPipelineCache(m_pDevice->GetDevice(), m_pipelineCache, nullptr);
+	vkDestroyPipelineLayout(m_pDevice->GetDevice(), m_pipelineLayout, nullptr);
 	m_pResourceViewHeaps->FreeDescriptor(m_easuDescriptorSet);
+	m_pResourceViewHeaps->FreeDescriptor(m_easuToIntermediaryDescriptorSet);
 	m_pResourceViewHeaps->FreeDescriptor(m_rcasDescriptorSet);
+	m_pResourceViewHeaps->FreeDescriptor(m_rcasToCompareDescriptorSet);
+	m_pResourceViewHeaps->FreeDescriptor(m_easuToCompareDescriptorSet);
 	vkDestroyDescriptorSetLayout(m_pDevice->GetDevice(), m_descriptorSetLayout, NULL);
 }
 
-void FSR_Filter::Upscale(VkCommandBuffer cmd_buf, int displayWidth, int displayHeight, State* pState, DynamicBufferRing* pConstantBufferRing, bool hdr)
+// The constants only depend on the resolutions and the sharpness, so they are rebuilt only when one of those changes.
+// The input is the renderWidth x renderHeight corner of a renderTargetWidth x renderTargetHeight texture, they differ with dynamic resolution.
+// HDR is a specialization constant. Sample is only used by the packed RCAS, which gets its frame index and grain amount in Upscale(),
+// and by the split screen, which offsets each strip's workgroups by Sample.x pixels.
+void FSR_Filter::UpdateConstants(int displayWidth, int displayHeight, State* pState)
+{
+	if (m_constsValid &&
+		m_constsRenderWidth == pState->renderWidth && m_constsRenderHeight == pState->renderHeight &&
+		m_constsTargetWidth == pState->renderTargetWidth && m_constsTargetHeight == pState->renderTargetHeight &&
+		m_constsDisplayWidth == displayWidth && m_constsDisplayHeight == displayHeight &&
+		m_constsSharpness == pState->rcasAttenuation)
+		return;
+
+	m_easuConsts = {};
+	FsrEasuConOffset(reinterpret_cast<AU1*>(&m_easuConsts.Const0), reinterpret_cast<AU1*>(&m_easuConsts.Const1), reinterpret_cast<AU1*>(&m_easuConsts.Const2), reinterpret_cast<AU1*>(&m_easuConsts.Const3), static_cast<AF1>(pState->renderWidth), static_cast<AF1>(pState->renderHeight), static_cast<AF1>(pState->renderTargetWidth), static_cast<AF1>(pState->renderTargetHeight), (AF1)displayWidth, (AF1)displayHeight, 0.0f, 0.0f);
+
+	// Last texel of the viewport, EASU and the bilinear pass don't read past it when it is smaller than the input texture.
+	// A 2x2 footprint starts on it once the coordinate passes its center, that limit is sent as a float so the check is a compare.
+	m_easuConsts.Viewport.x = AU1_AF1((pState->renderWidth - 0.5f) / pState->renderTargetWidth);
+	m_easuConsts.Viewport.y = AU1_AF1((pState->renderHeight - 0.5f) / pState->renderTargetHeight);
+	m_easuConsts.Viewport.z = pState->renderWidth - 1;
+	m_easuConsts.Viewport.w = pState->renderHeight - 1;
+
+	m_rcasConsts = {};
+	FsrRcasCon(reinterpret_cast<AU1*>(&m_rcasConsts.Const0), pState->rcasAttenuation);
+
+	// The fused pass needs both, plus the output size to clamp its halo.
+	m_fusedConsts = m_easuConsts;
+	m_fusedConsts.Const4 = m_rcasConsts.Const0;
+	m_fusedConsts.Const4.z = displayWidth;
+	m_fusedConsts.Const4.w = displayHeight;
+
+	m_constsValid = true;
+	m_constsRenderWidth = pState->renderWidth;
+	m_constsRenderHeight = pState->renderHeight;
+	m_constsTargetWidth = pState->renderTargetWidth;
+	m_constsTargetHeight = pState->renderTargetHeight;
+	m_constsDisplayWidth = displayWidth;
+	m_constsDisplayHeight = displayHeight;
+	m_constsSharpness = pState->rcasAttenuation;
+}
+
+void FSR_Filter::Dispatch(VkCommandBuffer cmd_buf, VkPipeline pipeline, VkDescriptorSet descriptorSet, const FSRConstants* pConsts, int dispatchX, int dispatchY, const char* statsLabel)
+{
+	std::vector<std::string>& labels = m_statsLabels[m_statsSlot];
+	bool stats = statsLabel && (m_statsQueryPool != VK_NULL_HANDLE) && (labels.size() < s_statsPerFrame);
+	uint32_t query = m_statsSlot * s_statsPerFrame + (uint32_t)labels.size();
+
+	vkCmdBindPipeline(cmd_buf, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+	vkCmdBindDescriptorSets(cmd_buf, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0, 1, &descriptorSet, 0, NULL);
+	vkCmdPushConstants(cmd_buf, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(FSRConstants), pConsts);
+	if (stats)
+	{
+		vkCmdBeginQuery(cmd_buf, m_statsQueryPool, query, 0);
+		labels.push_back(statsLabel);
+	}
+	vkCmdDispatch(cmd_buf, dispatchX, dispatchY, 1);
+	if (stats)
+		vkCmdEndQuery(cmd_buf, m_statsQueryPool, query);
+}
+
+// The frame that last used the slot is done: the swapchain fence of its slot was waited on before this frame was recorded.
+void FSR_Filter::ReadStatistics()
+{
+	std::vector<std::string>& labels = m_statsLabels[m_statsSlot];
+	if (!labels.empty())
+	{
+		std::vector<uint64_t> invocations(labels.size());
+		VkResult res = vkGetQueryPoolResults(m_pDevice->GetDevice(), m_statsQueryPool, m_statsSlot * s_statsPerFrame, (uint32_t)labels.size(),
+			invocations.size() * sizeof(uint64_t), invocations.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+		if (res == VK_SUCCESS)
+		{
+			m_passStatistics.resize(labels.size());
+			for (size_t i = 0; i < labels.size(); i++)
+			{
+				m_passStatistics[i].label = labels[i];
+				m_passStatistics[i].invocations = invocations[i];
+			}
+		}
+	}
+	labels.clear();
+}
+
+// Timestamps are only taken on the graphics queue, the async compute path measures its span on its own.
+static void TimeStamp(GPUTimestamps* pTimer, VkCommandBuffer cmd_buf, const char* label)
 {
-	VkDescriptorBufferInfo constsHandle;
+	if (pTimer)
+		pTimer->GetTimeStamp(cmd_buf, label);
+}
+
+void FSR_Filter::Upscale(VkCommandBuffer cmd_buf, int displayWidth, int displayHeight, State* pState, bool hdr, GPUTimestamps* pTimer, bool computeQueue)
+{
+	UpdateConstants(displayWidth, displayHeight, pState);
+	m_frameIndex++;
+	if (m_statsQueryPool != VK_NULL_HANDLE)
 	{
-		FSRConstants consts = {};
-		FsrEasuCon(reinterpret_cast<AU1*>(&consts.Const0), reinterpret_cast<AU1*>(&consts.Const1), reinterpret_cast<AU1*>(&consts.Const2), reinterpret_cast<AU1*>(&consts.Const3), static_cast<AF1>(pState->renderWidth), static_cast<AF1>(pState->renderHeight), static_cast<AF1>(pState->renderWidth), static_cast<AF1>(pState->renderHeight), (AF1)displayWidth, (AF1)displayHeight);
-		consts.Sample.x = (hdr && !pState->bUseRcas) ? 1 : 0;
-		uint32_t* pConstMem;
-		pConstantBufferRing->AllocConstantBuffer(sizeof(FSRConstants), reinterpret_cast<void**>(&pConstMem), &constsHandle);
-		memcpy(pConstMem, &consts, sizeof(FSRConstants));
+		m_statsSlot = m_frameIndex % backBufferCount;
+		ReadStatistics();
+		vkCmdResetQueryPool(cmd_buf, m_statsQueryPool, m_statsSlot * s_statsPerFrame, s_statsPerFrame);
 	}
 	// This value is the image region dimension that each thread group of the FSR shader operates on
 	static const int threadGroupWorkRegionDim = 16;
 	int dispatchX = (displayWidth + (threadGroupWorkRegionDim - 1)) / threadGroupWorkRegionDim;
 	int dispatchY = (displayHeight + (threadGroupWorkRegionDim - 1)) / threadGroupWorkRegionDim;
+
+	// The input comes straight out of the tonemapping render pass, the output was put in GENERAL at the start of the frame.
+	// The intermediary may share memory with the shadow map, so it starts over from UNDEFINED every frame, after SampleRenderer's aliasing barrier.
+	// On the compute queue both were acquired by FSR_AsyncCompute, which also hands them back afterwards.
+	m_inputState.layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	m_inputState.stages = computeQueue ? VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT : VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	m_inputState.access = computeQueue ? 0 : VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	m_outputState.layout = VK_IMAGE_LAYOUT_GENERAL;
+	m_outputState.stages = computeQueue ? VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+	m_outputState.access = 0;
+	m_intermediaryState.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+	m_intermediaryState.stages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+	m_intermediaryState.access = 0;
+
+	bool useRcas = pState->m_nUpscaleType && pState->bUseRcas;
+	bool fused = useRcas && pState->bUseFusedRcas;
+	bool split = (pState->m_nUpscaleType == 1) && pState->bSplitScreen;
+	m_precision = (m_fp16 && pState->bUseFp16) ? 1 : 0;
+	m_easuHx2 = (pState->m_nUpscaleType == 1) && pState->bUseEasuHx2 && m_precision && IsEasuHx2Available();
+	m_clampInput = (pState->renderWidth < pState->renderTargetWidth) || (pState->renderHeight < pState->renderTargetHeight);
+	const char* easuLabel = m_easuHx2 ? "FSR EASU Hx2" : "FSR EASU";
+	bool rcasHx2 = useRcas && !fused && pState->bUseRcasHx2 && m_precision;
+	// The reference is FsrEasuH, followed by the regular RCAS when sharpening is on. The packed RCAS would differ on its own.
+	bool compare = (fused || m_easuHx2) && !rcasHx2 && pState->bCompareFused && !split;
+	pState->bCompareFused = false;
+	if (m_comparePending)
+		ReadCompare();
+	// The readback is 32 bits per pixel, other output formats (the FP16 HDR one) are rejected before anything is recorded.
+	if (compare && CompareBits(m_outputFormat) == 0)
 	{
-		VkMemoryBarrier barrier[1] = {};
-		barrier[0].sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
-		barrier[0].srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT | VK_ACCESS_MEMORY_READ_BIT;
-		barrier[0].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
-		vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, barrier, 0, NULL, 0, NULL);
+		m_comparison = FusedComparison();
+		m_comparison.available = true;
+		compare = false;
 	}
-	if (pState->m_nUpscaleType)
+	if (compare && m_compareBuffer == VK_NULL_HANDLE)
+		CreateCompareResources();
+
+	Require(&m_inputState, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+	if (useRcas && !fused)
+		Require(&m_intermediaryState, VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, true);
+	// The split screen writes the output from its other paths while FSR still goes through the intermediary.
+	if (!(useRcas && !fused) || split)
+		Require(&m_outputState, VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, true);
+	FlushBarriers(cmd_buf);
+	TimeStamp(pTimer, cmd_buf, "FSR input barriers");
+
+	if (split)
+	{
+		SetPerfMarkerBegin(cmd_buf, "Split screen upscaling");
+		RecordSplit(cmd_buf, hdr, dispatchX, dispatchY, pState, fused, rcasHx2, pTimer);
+		SetPerfMarkerEnd(cmd_buf);
+	}
+	else if (pState->m_nUpscaleType)
 	{
 		SetPerfMarkerBegin(cmd_buf, "FSR upscaling");
-		if (pState->bUseRcas)
+		if (fused)
 		{
+			// EASU goes to groupshared memory and RCAS reads it from there, no intermediary and no barrier.
+			Dispatch(cmd_buf, GatherPipeline(FSR_PASS_FUSED, hdr), m_easuDescriptorSet, &m_fusedConsts, dispatchX, dispatchY, "FSR EASU + RCAS fused");
+			TimeStamp(pTimer, cmd_buf, "FSR EASU + RCAS fused");
+		}
+		else if (pState->bUseRcas)
+		{
+			Dispatch(cmd_buf, EasuPipeline(false), m_easuToIntermediaryDescriptorSet, &m_easuConsts, dispatchX, dispatchY, easuLabel);
+			TimeStamp(pTimer, cmd_buf, easuLabel);
+			Require(&m_intermediaryState, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+			Require(&m_outputState, VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, true);
+			FlushBarriers(cmd_buf);
+			TimeStamp(pTimer, cmd_buf, "FSR EASU>RCAS barrier");
+			if (rcasHx2)
 			{
-				VkDescriptorImageInfo ImgInfos[2] = {};
-				VkWriteDescriptorSet SetWrites[2] = {};
-
-				ImgInfos[0].sampler = VK_NULL_HANDLE;
-				ImgInfos[0].imageView = m_inputTextureSrv;
-				ImgInfos[0].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-				SetWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-				SetWrites[0].dstSet = m_easuDescriptorSet;
-				SetWrites[0].dstBinding = 1;
-				SetWrites[0].descriptorCount = 1;
-				SetWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-				SetWrites[0].pImageInfo = ImgInfos + 0;
-
-				// Dst img
-				ImgInfos[1].sampler = VK_NULL_HANDLE;
-				ImgInfos[1].imageView = m_intermediaryUav;
-				ImgInfos[1].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-
-				SetWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-				SetWrites[1].dstSet = m_easuDescriptorSet;
-				SetWrites[1].dstBinding = 2;
-				SetWrites[1].descriptorCount = 1;
-				SetWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-				SetWrites[1].pImageInfo = ImgInfos + 1;
-
-				vkUpdateDescriptorSets(m_pDevice->GetDevice(), _countof(SetWrites), SetWrites, 0, 0);
-			}
-			m_easu.Draw(cmd_buf, &constsHandle, m_easuDescriptorSet, dispatchX, dispatchY, 1);
-			{
-				FSRConstants consts = {};
-				FsrRcasCon(reinterpret_cast<AU1*>(&consts.Const0), pState->rcasAttenuation);
-				consts.Sample.x = (hdr ? 1 : 0);
-				uint32_t* pConstMem = 0;
-				pConstantBufferRing->AllocConstantBuffer(sizeof(FSRConstants), reinterpret_cast<void**>(&pConstMem), &constsHandle);
-				memcpy(pConstMem, &consts, sizeof(FSRConstants));
+				// Dither only makes sense for the 8-bit SDR output, HDR stores linear FP16.
+				uint32_t post = ((pState->bUseTepd && !hdr) ? FSR_POST_TEPD : 0) | (pState->bUseLfga ? FSR_POST_LFGA : 0);
+				m_rcasConsts.Sample.y = m_frameIndex;
+				m_rcasConsts.Sample.z = AU1_AF1(pState->lfgaAmount);
+				Dispatch(cmd_buf, m_rcasHx2Pipelines[hdr][post], m_rcasDescriptorSet, &m_rcasConsts, dispatchX, dispatchY, "FSR RCAS Hx2");
+				TimeStamp(pTimer, cmd_buf, "FSR RCAS Hx2");
 			}
-			VkImageMemoryBarrier barrier = {};
-			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-			barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-			barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-			barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			barrier.image = m_intermediary.Resource();
-			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-			barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			barrier.subresourceRange.baseMipLevel = 0;
-			barrier.subresourceRange.levelCount = 1;
-			barrier.subresourceRange.baseArrayLayer = 0;
-			barrier.subresourceRange.layerCount = 1;
-			vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, NULL, 0, NULL, 1, &barrier);
+			else
 			{
-				VkDescriptorImageInfo ImgInfos[2] = {};
-				VkWriteDescriptorSet SetWrites[2] = {};
-
-				ImgInfos[0].sampler = VK_NULL_HANDLE;
-				ImgInfos[0].imageView = m_intermediaryUav;
-				ImgInfos[0].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-				SetWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-				SetWrites[0].dstSet = m_rcasDescriptorSet;
-				SetWrites[0].dstBinding = 1;
-				SetWrites[0].descriptorCount = 1;
-				SetWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-				SetWrites[0].pImageInfo = ImgInfos + 0;
-
-				// Dst img
-				ImgInfos[1].sampler = VK_NULL_HANDLE;
-				ImgInfos[1].imageView = m_outputTextureUav;
-				ImgInfos[1].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-
-				SetWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-				SetWrites[1].dstSet = m_rcasDescriptorSet;
-				SetWrites[1].dstBinding = 2;
-				SetWrites[1].descriptorCount = 1;
-				SetWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-				SetWrites[1].pImageInfo = ImgInfos + 1;
-
-				vkUpdateDescriptorSets(m_pDevice->GetDevice(), _countof(SetWrites), SetWrites, 0, 0);
+				Dispatch(cmd_buf, m_pipelines[m_precision][FSR_PASS_RCAS][hdr], m_rcasDescriptorSet, &m_rcasConsts, dispatchX, dispatchY, "FSR RCAS");
+				TimeStamp(pTimer, cmd_buf, "FSR RCAS");
 			}
-			m_rcas.Draw(cmd_buf, &constsHandle, m_rcasDescriptorSet, dispatchX, dispatchY, 1);
-			barrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
-			vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, NULL, 0, NULL, 1, &barrier);
 		}
 		else
 		{
-			VkDescriptorImageInfo ImgInfos[2] = {};
-			VkWriteDescriptorSet SetWrites[2] = {};
-
-			ImgInfos[0].sampler = VK_NULL_HANDLE;
-			ImgInfos[0].imageView = m_inputTextureSrv;
-			ImgInfos[0].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-			SetWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			SetWrites[0].dstSet = m_easuDescriptorSet;
-			SetWrites[0].dstBinding = 1;
-			SetWrites[0].descriptorCount = 1;
-			SetWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-			SetWrites[0].pImageInfo = ImgInfos + 0;
-
-			// Dst img
-			ImgInfos[1].sampler = VK_NULL_HANDLE;
-			ImgInfos[1].imageView = m_outputTextureUav;
-			ImgInfos[1].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-
-			SetWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			SetWrites[1].dstSet = m_easuDescriptorSet;
-			SetWrites[1].dstBinding = 2;
-			SetWrites[1].descriptorCount = 1;
-			SetWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-			SetWrites[1].pImageInfo = ImgInfos + 1;
-
-			vkUpdateDescriptorSets(m_pDevice->GetDevice(), _countof(SetWrites), SetWrites, 0, 0);
-			m_easu.Draw(cmd_buf, &constsHandle, m_easuDescriptorSet, dispatchX, dispatchY, 1);
+			Dispatch(cmd_buf, EasuPipeline(hdr), m_easuDescriptorSet, &m_easuConsts, dispatchX, dispatchY, easuLabel);
+			TimeStamp(pTimer, cmd_buf, easuLabel);
 		}
 		SetPerfMarkerEnd(cmd_buf);
 	} else
 	{
 		SetPerfMarkerBegin(cmd_buf, "Bilinear upscaling");
-		VkDescriptorImageInfo ImgInfos[2] = {};
-		VkWriteDescriptorSet SetWrites[2] = {};
-
-		ImgInfos[0].sampler = VK_NULL_HANDLE;
-		ImgInfos[0].imageView = m_inputTextureSrv;
-		ImgInfos[0].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-		SetWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		SetWrites[0].dstSet = m_easuDescriptorSet;
-		SetWrites[0].dstBinding = 1;
-		SetWrites[0].descriptorCount = 1;
-		SetWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-		SetWrites[0].pImageInfo = ImgInfos + 0;
-
-		// Dst img
-		ImgInfos[1].sampler = VK_NULL_HANDLE;
-		ImgInfos[1].imageView = m_outputTextureUav;
-		ImgInfos[1].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-
-		SetWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		SetWrites[1].dstSet = m_easuDescriptorSet;
-		SetWrites[1].dstBinding = 2;
-		SetWrites[1].descriptorCount = 1;
-		SetWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-		SetWrites[1].pImageInfo = ImgInfos + 1;
-
-		vkUpdateDescriptorSets(m_pDevice->GetDevice(), _countof(SetWrites), SetWrites, 0, 0);
-		m_bilinear.Draw(cmd_buf, &constsHandle, m_easuDescriptorSet, dispatchX, dispatchY, 1);
+		Dispatch(cmd_buf, m_pipelines[m_precision][FSR_PASS_BILINEAR][0], m_easuDescriptorSet, &m_easuConsts, dispatchX, dispatchY, "Bilinear upscaling");
 		SetPerfMarkerEnd(cmd_buf);
+		TimeStamp(pTimer, cmd_buf, "Bilinear upscaling");
 	}
+
+	if (compare)
+	{
+		RecordCompare(cmd_buf, hdr, dispatchX, dispatchY, useRcas);
+		TimeStamp(pTimer, cmd_buf, "FSR comparison");
+	}
+
+	if (computeQueue)
 	{
-		VkMemoryBarrier barrier[1] = {};
-		barrier[0].sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
-		barrier[0].srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT | VK_ACCESS_MEMORY_READ_BIT;
-		barrier[0].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
-		vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, barrier, 0, NULL, 0, NULL);
+		FlushBarriers(cmd_buf);
+		return;
 	}
+
+	// Hand the output over to the UI and magnifier passes, which draw into it or sample it right after.
+	Require(&m_outputState, VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+		VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT);
+	FlushBarriers(cmd_buf);
+	TimeStamp(pTimer, cmd_buf, "FSR output barrier");
 }
 
+// Vertical strips of whole workgroups, left to right: FSR as configured, bilinear, then EASU alone when asked for.
+// All of them read the same input in the same frame, so their timings only differ by the filter.
+// Every path after the first starts behind an execution barrier on the output, which keeps their timestamps from overlapping.
+void FSR_Filter::RecordSplit(VkCommandBuffer cmd_buf, bool hdr, int dispatchX, int dispatchY, State* pState, bool fused, bool rcasHx2, GPUTimestamps* pTimer)
+{
+	bool easuOnly = pState->bUseRcas && pState->bSplitScreenEasu;
+	int paths = easuOnly ? 3 : 2;
+	int stripGroups = (dispatchX + paths - 1) / paths;
+	int origin = 0;
+	int groups = std::min<int>(stripGroups, dispatchX);
+
+	if (fused)
+	{
+		FSRConstants consts = m_fusedConsts;
+		consts.Sample.x = origin;
+		Dispatch(cmd_buf, GatherPipeline(FSR_PASS_FUSED, hdr), m_easuDescriptorSet, &consts, groups, dispatchY, "Split FSR EASU + RCAS fused");
+		TimeStamp(pTimer, cmd_buf, "Split FSR EASU + RCAS fused");
+	}
+	else if (pState->bUseRcas)
+	{
+		// RCAS reads one pixel past the strip, EASU covers one more workgroup column for it when there is one.
+		FSRConstants consts = m_easuConsts;
+		consts.Sample.x = origin;
+		Dispatch(cmd_buf, EasuPipeline(false), m_easuToIntermediaryDescriptorSet, &consts, std::min<int>(groups + 1, dispatchX), dispatchY, "Split FSR EASU");
+		TimeStamp(pTimer, cmd_buf, "Split FSR EASU");
+		Require(&m_intermediaryState, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+		Require(&m_outputState, VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+		FlushBarriers(cmd_buf);
+		consts = m_rcasConsts;
+		consts.Sample.x = origin;
+		if (rcasHx2)
+		{
+			uint32_t post = ((pState->bUseTepd && !hdr) ? FSR_POST_TEPD : 0) | (pState->bUseLfga ? FSR_POST_LFGA : 0);
+			consts.Sample.y = m_frameIndex;
+			consts.Sample.z = AU1_AF1(pState->lfgaAmount);
+			Dispatch(cmd_buf, m_rcasHx2Pipelines[hdr][post], m_rcasDescriptorSet, &consts, groups, dispatchY, "Split FSR RCAS Hx2");
+			TimeStamp(pTimer, cmd_buf, "Split FSR RCAS Hx2");
+		}
+		else
+		{
+			Dispatch(cmd_buf, m_pipelines[m_precision][FSR_PASS_RCAS][hdr], m_rcasDescriptorSet, &consts, groups, dispatchY, "Split FSR RCAS");
+			TimeStamp(pTimer, cmd_buf, "Split FSR RCAS");
+		}
+	}
+	else
+	{
+		FSRConstants consts = m_easuConsts;
+		consts.Sample.x = origin;
+		Dispatch(cmd_buf, EasuPipeline(hdr), m_easuDescriptorSet, &consts, groups, dispatchY, "Split FSR EASU");
+		TimeStamp(pTimer, cmd_buf, "Split FSR EASU");
+	}
+
+	// The bilinear pipeline squares in HDR like the others, the input is tonemapped for FSR.
+	origin += groups * 16;
+	groups = std::max<int>(std::min<int>(stripGroups, dispatchX - stripGroups), 0);
+	Require(&m_outputState, VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+	FlushBarriers(cmd_buf);
+	FSRConstants consts = m_easuConsts;
+	consts.Sample.x = origin;
+	Dispatch(cmd_buf, m_pipelines[m_precision][FSR_PASS_BILINEAR][hdr], m_easuDescriptorSet, &consts, groups, dispatchY, "Split bilinear");
+	TimeStamp(pTimer, cmd_buf, "Split bilinear");
+
+	if (easuOnly)
+	{
+		origin += groups * 16;
+		groups = std::max<int>(dispatchX - 2 * stripGroups, 0);
+		Require(&m_outputState, VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+		FlushBarriers(cmd_buf);
+		consts.Sample.x = origin;
+		Dispatch(cmd_buf, EasuPipeline(hdr), m_easuDescriptorSet, &consts, groups, dispatchY, "Split EASU only");
+		TimeStamp(pTimer, cmd_buf, "Split EASU only");
+	}
+}
+
+void FSR_Filter::CreateCompareResources()
+{
+	m_compare.InitRenderTarget(m_pDevice, m_displayWidth, m_displayHeight, m_outputFormat, VK_SAMPLE_COUNT_1_BIT, (VkImageUsageFlags)(VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT), false, "FSR Compare");
+
+	VkImageViewCreateInfo info = {};
+	info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	info.image = m_compare.Resource();
+	info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	info.format = m_outputFormat;
+	info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	info.subresourceRange.baseMipLevel = 0;
+	info.subresourceRange.levelCount = 1;
+	info.subresourceRange.baseArrayLayer = 0;
+	info.subresourceRange.layerCount = 1;
+	VkResult res = vkCreateImageView(m_pDevice->GetDevice(), &info, NULL, &m_compareUav);
+	assert(res == VK_SUCCESS);
+	UpdateDescriptorSet(m_rcasToCompareDescriptorSet, m_intermediaryUav, m_compareUav);
+	UpdateDescriptorSet(m_easuToCompareDescriptorSet, m_inputTextureSrv, m_compareUav);
+	m_compareState = ImageState();
+	m_compareState.image = m_compare.Resource();
+
+	// Readback of the fused output followed by the two-pass one, both tightly packed. Only 32 bit formats get here, see CompareBits().
+	VkBufferCreateInfo bufferInfo = {};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.size = (VkDeviceSize)m_displayWidth * m_displayHeight * sizeof(uint32_t) * 2;
+	bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	res = vkCreateBuffer(m_pDevice->GetDevice(), &bufferInfo, NULL, &m_compareBuffer);
+	assert(res == VK_SUCCESS);
+
+	VkMemoryRequirements requirements;
+	vkGetBufferMemoryRequirements(m_pDevice->GetDevice(), m_compareBuffer, &requirements);
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	vkGetPhysicalDeviceMemoryProperties(m_pDevice->GetPhysicalDevice(), &memoryProperties);
+	const VkMemoryPropertyFlags wanted[] = {
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT };
+	uint32_t memoryType = UINT32_MAX;
+	for (int w = 0; w < (int)_countof(wanted) && memoryType == UINT32_MAX; w++)
+		for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+			if ((requirements.memoryTypeBits & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & wanted[w]) == wanted[w])
+			{
+				memoryType = i;
+				break;
+			}
+	assert(memoryType != UINT32_MAX);
+
+	VkMemoryAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = requirements.size;
+	allocInfo.memoryTypeIndex = memoryType;
+	res = vkAllocateMemory(m_pDevice->GetDevice(), &allocInfo, NULL, &m_compareMemory);
+	assert(res == VK_SUCCESS);
+	res = vkBindBufferMemory(m_pDevice->GetDevice(), m_compareBuffer, m_compareMemory, 0);
+	assert(res == VK_SUCCESS);
+}
+
+void FSR_Filter::DestroyCompareResources()
+{
+	if (m_compareBuffer == VK_NULL_HANDLE)
+		return;
+	m_compare.OnDestroy();
+	vkDestroyImageView(m_pDevice->GetDevice(), m_compareUav, 0);
+	vkDestroyBuffer(m_pDevice->GetDevice(), m_compareBuffer, 0);
+	vkFreeMemory(m_pDevice->GetDevice(), m_compareMemory, 0);
+	m_compareUav = VK_NULL_HANDLE;
+	m_compareBuffer = VK_NULL_HANDLE;
+	m_compareMemory = VK_NULL_HANDLE;
+	m_comparePending = false;
+}
+
+// Runs the reference path into m_compare next to the output: FsrEasuH, then the two-pass RCAS with 'rcas'.
+// Both are then copied to the readback buffer.
+void FSR_Filter::RecordCompare(VkCommandBuffer cmd_buf, bool hdr, int dispatchX, int dispatchY, bool rcas)
+{
+	SetPerfMarkerBegin(cmd_buf, "FSR comparison");
+	if (!rcas)
+	{
+		Require(&m_compareState, VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, true);
+		FlushBarriers(cmd_buf);
+		Dispatch(cmd_buf, GatherPipeline(FSR_PASS_EASU, hdr), m_easuToCompareDescriptorSet, &m_easuConsts, dispatchX, dispatchY);
+	}
+	else
+	{
+		Require(&m_intermediaryState, VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, true);
+		FlushBarriers(cmd_buf);
+		Dispatch(cmd_buf, GatherPipeline(FSR_PASS_EASU, false), m_easuToIntermediaryDescriptorSet, &m_easuConsts, dispatchX, dispatchY);
+		Require(&m_intermediaryState, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+		Require(&m_compareState, VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, true);
+		FlushBarriers(cmd_buf);
+		Dispatch(cmd_buf, m_pipelines[m_precision][FSR_PASS_RCAS][hdr], m_rcasToCompareDescriptorSet, &m_rcasConsts, dispatchX, dispatchY);
+	}
+
+	Require(&m_outputState, VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+	Require(&m_compareState, VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+	FlushBarriers(cmd_buf);
+
+	VkBufferImageCopy region = {};
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.layerCount = 1;
+	region.imageExtent = { (uint32_t)m_displayWidth, (uint32_t)m_displayHeight, 1 };
+	vkCmdCopyImageToBuffer(cmd_buf, m_outputState.image, VK_IMAGE_LAYOUT_GENERAL, m_compareBuffer, 1, &region);
+	region.bufferOffset = (VkDeviceSize)m_displayWidth * m_displayHeight * sizeof(uint32_t);
+	vkCmdCopyImageToBuffer(cmd_buf, m_compareState.image, VK_IMAGE_LAYOUT_GENERAL, m_compareBuffer, 1, &region);
+
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, NULL, 0, NULL);
+	SetPerfMarkerEnd(cmd_buf);
+
+	m_comparePending = true;
+}
+
+// Bits per channel of the output formats the comparison can read back, 0 for the others.
+uint32_t FSR_Filter::CompareBits(VkFormat format)
+{
+	switch (format)
+	{
+	case VK_FORMAT_R8G8B8A8_UNORM:
+	case VK_FORMAT_B8G8R8A8_UNORM:
+		return 8;
+	case VK_FORMAT_A2R10G10B10_UNORM_PACK32:
+	case VK_FORMAT_A2B10G10R10_UNORM_PACK32:
+		return 10;
+	default:
+		return 0;
+	}
+}
+
+// Called on the frame after RecordCompare(), the flush makes sure the copies have landed.
+// The fused path keeps EASU at full precision while the two-pass one rounds it to the intermediary format, so differences of one step are expected.
+// The packed EASU is expected to match FsrEasuH up to fp16 rounding.
+void FSR_Filter::ReadCompare()
+{
+	m_comparePending = false;
+	m_pDevice->GPUFlush();
+
+	m_comparison = FusedComparison();
+	m_comparison.available = true;
+	uint32_t bits = CompareBits(m_outputFormat);
+	assert(bits != 0);
+	m_comparison.supported = true;
+	m_comparison.maxValue = (1u << bits) - 1;
+
+	void* pData = NULL;
+	VkResult res = vkMapMemory(m_pDevice->GetDevice(), m_compareMemory, 0, VK_WHOLE_SIZE, 0, &pData);
+	assert(res == VK_SUCCESS);
+	const uint32_t* pFused = static_cast<const uint32_t*>(pData);
+	const uint32_t* pTwoPass = pFused + m_displayWidth * m_displayHeight;
+
+	// The two-pass RCAS reads outside the image on the border, so it is left out.
+	uint64_t sum = 0, above = 0, count = 0;
+	for (int y = 1; y < m_displayHeight - 1; y++)
+	{
+		for (int x = 1; x < m_displayWidth - 1; x++)
+		{
+			uint32_t a = pFused[y * m_displayWidth + x];
+			uint32_t b = pTwoPass[y * m_displayWidth + x];
+			uint32_t pixelMax = 0;
+			for (uint32_t c = 0; c < 3; c++)
+			{
+				int32_t ca = (a >> (c * bits)) & m_comparison.maxValue;
+				int32_t cb = (b >> (c * bits)) & m_comparison.maxValue;
+				uint32_t diff = (uint32_t)abs(ca - cb);
+				pixelMax = (diff > pixelMax) ? diff : pixelMax;
+				sum += diff;
+			}
+			m_comparison.maxDiff = (pixelMax > m_comparison.maxDiff) ? pixelMax : m_comparison.maxDiff;
+			above += (pixelMax > 1) ? 1 : 0;
+			count++;
+		}
+	}
+	vkUnmapMemory(m_pDevice->GetDevice(), m_compareMemory);
+
+	if (count)
+	{
+		m_comparison.meanDiff = (float)((double)sum / (double)(count * 3));
+		m_comparison.percentAboveOne = (float)(100.0 * (double)above / (double)count);
+	}
+}
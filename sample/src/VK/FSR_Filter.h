@@ -18,31 +18,177 @@
 // THE SOFTWARE.
 
 #pragma once
-#include "PostProc/PostProcCS.h"
+#include <DirectXMath.h>
 
 struct State;
+class TransientAllocator;
+
+// Sent to the FSR passes as push constants, see FSR_Pass.glsl/hlsl.
+struct FSRConstants
+{
+	DirectX::XMUINT4 Const0;
+	DirectX::XMUINT4 Const1;
+	DirectX::XMUINT4 Const2;
+	DirectX::XMUINT4 Const3;
+	DirectX::XMUINT4 Sample;
+	DirectX::XMUINT4 Const4;
+	DirectX::XMUINT4 Viewport;
+};
 
 class FSR_Filter
 {
 public:
-	void OnCreate(Device* pDevice, ResourceViewHeaps* pResourceViewHeaps, DynamicBufferRing* pConstantBufferRing, bool glsl);
+	// With a pool the shaders and pipelines are created on it, the caller flushes it before the first Upscale().
+	void OnCreate(Device* pDevice, ResourceViewHeaps* pResourceViewHeaps, bool glsl, AsyncPool* pAsyncPool = NULL);
+	// Declares the intermediary, it has to be allocated before OnCreateWindowSizeDependentResources() makes its view.
+	void CreateIntermediary(TransientAllocator* pAllocator, int displayWidth, int displayHeight, bool hdr);
 	void OnCreateWindowSizeDependentResources(Device* pDevice, VkImage input, VkImage output, VkFormat outputFormat, int displayWidth, int displayHeight, State* pState, bool hdr);
 	void OnDestroyWindowSizeDependentResources();
 	void OnDestroy();
-	void Upscale(VkCommandBuffer cmd_buf, int displayWidth, int displayHeight, State *pState, DynamicBufferRing* pConstantBufferRing, bool hdr);
+	// Timestamps are taken per pass so the RCAS variants can be told apart in the profiler, pTimer can be NULL.
+	// With computeQueue the images are expected to be acquired already and handing them back is left to the caller.
+	void Upscale(VkCommandBuffer cmd_buf, int displayWidth, int displayHeight, State *pState, bool hdr, GPUTimestamps* pTimer, bool computeQueue = false);
+
+	// Result of the last comparison of the fused pass or the packed EASU against FsrEasuH (+ two-pass RCAS),
+	// in steps of the output format. The one pixel border is skipped.
+	struct FusedComparison
+	{
+		bool                        available = false;
+		bool                        supported = false;
+		uint32_t                    maxDiff = 0;
+		uint32_t                    maxValue = 0;
+		float                       meanDiff = 0.0f;
+		float                       percentAboveOne = 0.0f;
+	};
+	const FusedComparison& GetFusedComparison() const { return m_comparison; }
+
+	// Compute shader invocations of each dispatch, labelled like its timestamp. From the last frame that was read back,
+	// empty when the device has no pipeline statistics queries.
+	struct PassStatistics
+	{
+		std::string                 label;
+		uint64_t                    invocations = 0;
+	};
+	const std::vector<PassStatistics>& GetPassStatistics() const { return m_passStatistics; }
+
+	// The packed EASU needs fp16 and its own module, State::bUseEasuHx2 is ignored without it.
+	bool IsEasuHx2Available() const { return m_pipelines[1][FSR_PASS_EASU_HX2][0] != VK_NULL_HANDLE; }
 
 private:
+	// Last known layout and access of an image the filter touches, used to emit only the barriers that are needed.
+	struct ImageState
+	{
+		VkImage                     image = VK_NULL_HANDLE;
+		VkImageLayout               layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		VkPipelineStageFlags        stages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+		VkAccessFlags               access = 0;
+	};
+	void Require(ImageState* pImage, VkImageLayout layout, VkPipelineStageFlags stages, VkAccessFlags access, bool discard = false);
+	void FlushBarriers(VkCommandBuffer cmd_buf);
+	void UpdateDescriptorSet(VkDescriptorSet descriptorSet, VkImageView input, VkImageView output);
+	// Values of the SamplePass specialization constant in FSR_Pass.glsl/hlsl.
+	enum FSRPass
+	{
+		FSR_PASS_BILINEAR,
+		FSR_PASS_EASU,
+		FSR_PASS_RCAS,
+		FSR_PASS_FUSED,
+		FSR_PASS_RCAS_HX2,
+		FSR_PASS_EASU_HX2,
+		FSR_PASS_COUNT
+	};
+	// Stages fused into the store of the packed RCAS pass, the SampleTepd and SampleLfga specialization constants.
+	enum FSRPost
+	{
+		FSR_POST_TEPD = 1,
+		FSR_POST_LFGA = 2,
+		FSR_POST_COUNT = 4
+	};
+	// Loads the precompiled SPIR-V, or compiles the module from source when it is missing.
+	bool CreateShader(const char* spirv, const char* source, const char* flags, bool fp16, bool easuHx2, VkPipelineShaderStageCreateInfo* pShader);
+	bool LoadPrecompiledShader(const char* name, VkPipelineShaderStageCreateInfo* pShader);
+	void CreatePipelineCache();
+	void SavePipelineCache();
+	void CreatePipeline(bool fp16, FSRPass pass, bool hdr, VkPipeline* pPipeline, uint32_t post = 0, bool clampInput = false);
+	void UpdateConstants(int displayWidth, int displayHeight, State* pState);
+	// With a label the dispatch is bracketed by a pipeline statistics query.
+	void Dispatch(VkCommandBuffer cmd_buf, VkPipeline pipeline, VkDescriptorSet descriptorSet, const FSRConstants* pConsts, int dispatchX, int dispatchY, const char* statsLabel = NULL);
+	void ReadStatistics();
+	// The passes that gather the input, with the SampleClampInput variant when the render viewport is smaller than the texture.
+	VkPipeline GatherPipeline(FSRPass pass, bool hdr) const { return (m_clampInput ? m_clampPipelines : m_pipelines)[m_precision][pass][hdr]; }
+	VkPipeline EasuPipeline(bool hdr) const { return GatherPipeline(m_easuHx2 ? FSR_PASS_EASU_HX2 : FSR_PASS_EASU, hdr); }
+	void CreateCompareResources();
+	void DestroyCompareResources();
+	void RecordCompare(VkCommandBuffer cmd_buf, bool hdr, int dispatchX, int dispatchY, bool rcas);
+	// Split screen: each path upscales its own strip of the output, with its own timestamps and statistics.
+	void RecordSplit(VkCommandBuffer cmd_buf, bool hdr, int dispatchX, int dispatchY, State* pState, bool fused, bool rcasHx2, GPUTimestamps* pTimer);
+	void ReadCompare();
+	static uint32_t CompareBits(VkFormat format);
+
 	Device							*m_pDevice = 0;
 	ResourceViewHeaps				*m_pResourceViewHeaps = 0;
-	PostProcCS                      m_easu;
-	PostProcCS                      m_rcas;
-	PostProcCS                      m_bilinear;
+	VkPipelineShaderStageCreateInfo m_computeShader[2] = {}; // [fp16], the fp16 module only exists when the device supports it
+	VkPipelineShaderStageCreateInfo m_easuHx2Shader = {}; // fp16 module of FSR_PASS_EASU_HX2
+	VkPipelineCache                 m_pipelineCache = VK_NULL_HANDLE;
+	std::string                     m_pipelineCachePath;
+	VkPipeline                      m_pipelines[2][FSR_PASS_COUNT][2] = {}; // [fp16][pass][hdr], FSR_PASS_RCAS_HX2 lives in m_rcasHx2Pipelines, FSR_PASS_EASU_HX2 is fp16 only and may be missing
+	VkPipeline                      m_clampPipelines[2][FSR_PASS_COUNT][2] = {}; // same layout, only FSR_PASS_EASU, FSR_PASS_EASU_HX2 and FSR_PASS_FUSED
+	VkPipeline                      m_rcasHx2Pipelines[2][FSR_POST_COUNT] = {}; // [hdr][post], fp16 only
+	bool                            m_fp16 = false;
+	int                             m_precision = 0; // pipelines the current Upscale() uses, 1 for fp16
+	bool                            m_easuHx2 = false; // the current Upscale() runs the packed EASU
+	bool                            m_clampInput = false; // the current Upscale() reads a viewport smaller than the input texture
+	uint32_t                        m_frameIndex = 0;
+	VkPipelineLayout                m_pipelineLayout = VK_NULL_HANDLE;
 	VkImageView                     m_outputTextureUav;
 	VkImageView                     m_inputTextureSrv;
-	Texture							m_intermediary;
+	VkImage                         m_intermediary = VK_NULL_HANDLE; // owned by the TransientAllocator
 	VkImageView                     m_intermediaryUav;
 	VkSampler						m_sampler;
 	VkDescriptorSet					m_easuDescriptorSet;
+	VkDescriptorSet					m_easuToIntermediaryDescriptorSet;
 	VkDescriptorSet					m_rcasDescriptorSet;
+	VkDescriptorSet					m_rcasToCompareDescriptorSet;
+	VkDescriptorSet					m_easuToCompareDescriptorSet;
 	VkDescriptorSetLayout			m_descriptorSetLayout;
+
+	// Constants of the last Upscale() and what they were built from.
+	FSRConstants                    m_easuConsts = {};
+	FSRConstants                    m_rcasConsts = {};
+	FSRConstants                    m_fusedConsts = {};
+	bool                            m_constsValid = false;
+	uint32_t                        m_constsRenderWidth = 0;
+	uint32_t                        m_constsRenderHeight = 0;
+	uint32_t                        m_constsTargetWidth = 0;
+	uint32_t                        m_constsTargetHeight = 0;
+	int                             m_constsDisplayWidth = 0;
+	int                             m_constsDisplayHeight = 0;
+	float                           m_constsSharpness = 0.0f;
+
+	// One slot of s_statsPerFrame queries per frame in flight, read back when the slot comes around again.
+	static const uint32_t           s_statsPerFrame = 4;
+	VkQueryPool                     m_statsQueryPool = VK_NULL_HANDLE;
+	uint32_t                        m_statsSlot = 0;
+	std::vector<std::vector<std::string>> m_statsLabels; // [slot], the queries written in it
+	std::vector<PassStatistics>     m_passStatistics;
+
+	ImageState                      m_inputState;
+	ImageState                      m_outputState;
+	ImageState                      m_intermediaryState;
+	ImageState                      m_compareState;
+	std::vector<VkImageMemoryBarrier> m_pendingBarriers;
+	VkPipelineStageFlags            m_pendingSrcStages = 0;
+	VkPipelineStageFlags            m_pendingDstStages = 0;
+
+	// Comparison: the reference result goes to m_compare, then both images are read back on the CPU.
+	// Created on the first request only.
+	int                             m_displayWidth = 0;
+	int                             m_displayHeight = 0;
+	VkFormat                        m_outputFormat = VK_FORMAT_UNDEFINED;
+	Texture                         m_compare;
+	VkImageView                     m_compareUav = VK_NULL_HANDLE;
+	VkBuffer                        m_compareBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory                  m_compareMemory = VK_NULL_HANDLE;
+	bool                            m_comparePending = false;
+	FusedComparison                 m_comparison;
 };
@@ -22,98 +22,280 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 // THE SOFTWARE.
 
-layout(set=0,binding=0) uniform const_buffer
+layout(push_constant) uniform const_buffer
 {
 	uvec4 Const0;
 	uvec4 Const1;
 	uvec4 Const2;
 	uvec4 Const3;
-	uvec4 Sample;
+	uvec4 Sample; // x: first output column of the dispatch (split screen), yz: packed RCAS frame index and grain amount.
+	uvec4 Const4; // Fused pass only: RCAS constants in xy, output size in zw.
+	uvec4 Viewport; // EASU / bilinear: xy the coordinate past which a 2x2 footprint leaves the render viewport (float), zw its last texel.
 };
 
+// Specialization constants, picked per pipeline by FSR_Filter so the pass and HDR branches fold away.
+// Precision stays a define (SAMPLE_SLOW_FALLBACK) since the fp16 path needs device features the fallback can't declare.
+#define SAMPLE_PASS_BILINEAR 0
+#define SAMPLE_PASS_EASU 1
+#define SAMPLE_PASS_RCAS 2
+#define SAMPLE_PASS_FUSED 3
+#define SAMPLE_PASS_RCAS_HX2 4
+#define SAMPLE_PASS_EASU_HX2 5
+layout(constant_id=0) const uint SamplePass = SAMPLE_PASS_EASU;
+layout(constant_id=1) const bool SampleHdr = false;
+// Packed RCAS only: temporal energy preserving dither and film grain, fused into the store.
+layout(constant_id=2) const bool SampleTepd = false;
+layout(constant_id=3) const bool SampleLfga = false;
+// EASU passes only: the render viewport is smaller than the input texture, gathers reaching past it are clamped.
+layout(constant_id=4) const bool SampleClampInput = false;
+// The packed EASU is a module of its own (SAMPLE_EASU_HX2, fp16 only), the other passes don't carry FsrEasuHx2.
+#ifndef SAMPLE_EASU_HX2
+	#define SAMPLE_EASU_HX2 0
+#endif
+
 #define A_GPU 1
 #define A_GLSL 1
 
 #if SAMPLE_SLOW_FALLBACK
 	#include "ffx_a.h"
-	layout(set=0,binding=1) uniform texture2D InputTexture;
-	layout(set=0,binding=2,rgba32f) uniform image2D OutputTexture;
-	layout(set=0,binding=3) uniform sampler InputSampler;
-	#if SAMPLE_EASU
-		#define FSR_EASU_F 1
-		AF4 FsrEasuRF(AF2 p) { AF4 res = textureGather(sampler2D(InputTexture,InputSampler), p, 0); return res; }
-		AF4 FsrEasuGF(AF2 p) { AF4 res = textureGather(sampler2D(InputTexture,InputSampler), p, 1); return res; }
-		AF4 FsrEasuBF(AF2 p) { AF4 res = textureGather(sampler2D(InputTexture,InputSampler), p, 2); return res; }
-	#endif
-	#if SAMPLE_RCAS
-		#define FSR_RCAS_F
-		AF4 FsrRcasLoadF(ASU2 p) { return texelFetch(sampler2D(InputTexture,InputSampler), ASU2(p), 0); }
-		void FsrRcasInputF(inout AF1 r, inout AF1 g, inout AF1 b) {}
-	#endif
 #else
 	#define A_HALF
 	#include "ffx_a.h"
-	layout(set=0,binding=1) uniform texture2D InputTexture;
+#endif
+
+// Fused pass: EASU output of the workgroup's 16x16 region plus a 1 pixel halo, RCAS reads its taps from here.
+#define FUSED_TILE_DIM 18u
+shared AF1 FusedTileR[FUSED_TILE_DIM * FUSED_TILE_DIM];
+shared AF1 FusedTileG[FUSED_TILE_DIM * FUSED_TILE_DIM];
+shared AF1 FusedTileB[FUSED_TILE_DIM * FUSED_TILE_DIM];
+ASU2 FusedTileOrigin;
+AF3 FusedTileLoad(ASU2 p)
+{
+	AU1 i = AU1(p.x - FusedTileOrigin.x) + AU1(p.y - FusedTileOrigin.y) * FUSED_TILE_DIM;
+	return AF3(FusedTileR[i], FusedTileG[i], FusedTileB[i]);
+}
+
+layout(set=0,binding=1) uniform texture2D InputTexture;
+layout(set=0,binding=3) uniform sampler InputSampler;
+
+// The render viewport can be smaller than the input texture (dynamic resolution), what lies past it is left over from other frames.
+// With SampleClampInput a gather whose 2x2 footprint reaches past the last column or row is replaced by four clamped fetches,
+// which replicate the edge of the viewport like the sampler does at the edge of the texture. Without it the check folds away.
+AF2 InputLimit() { return AF2_AU2(Viewport.xy); }
+ASU2 InputMaxTexel() { return ASU2(Viewport.zw); }
+bool InputGatherInside(AF2 p) { return all(lessThan(p, InputLimit())); }
+ASU2 InputGatherTexel(AF2 p) { return ASU2(floor(p * AF2(textureSize(sampler2D(InputTexture,InputSampler), 0)) - AF2_(0.5))); }
+AF4 InputGatherClamped(AF2 p, AU1 c)
+{
+	ASU2 t0 = clamp(InputGatherTexel(p), ASU2(0, 0), InputMaxTexel());
+	ASU2 t1 = min(t0 + ASU2(1, 1), InputMaxTexel());
+	// Same order as textureGather: (0,1) (1,1) (1,0) (0,0)
+	return AF4(texelFetch(sampler2D(InputTexture,InputSampler), ASU2(t0.x, t1.y), 0)[c], texelFetch(sampler2D(InputTexture,InputSampler), t1, 0)[c],
+		texelFetch(sampler2D(InputTexture,InputSampler), ASU2(t1.x, t0.y), 0)[c], texelFetch(sampler2D(InputTexture,InputSampler), t0, 0)[c]);
+}
+AF4 InputGather(AF2 p, AU1 c)
+{
+	if (SampleClampInput && !InputGatherInside(p))
+		return InputGatherClamped(p, c);
+	// The component has to be a constant expression.
+	if (c == 0u)
+		return textureGather(sampler2D(InputTexture,InputSampler), p, 0);
+	if (c == 1u)
+		return textureGather(sampler2D(InputTexture,InputSampler), p, 1);
+	return textureGather(sampler2D(InputTexture,InputSampler), p, 2);
+}
+
+#if SAMPLE_SLOW_FALLBACK
+	layout(set=0,binding=2,rgba32f) uniform image2D OutputTexture;
+	#define FSR_EASU_F 1
+	AF4 FsrEasuRF(AF2 p) { AF4 res = InputGather(p, 0u); return res; }
+	AF4 FsrEasuGF(AF2 p) { AF4 res = InputGather(p, 1u); return res; }
+	AF4 FsrEasuBF(AF2 p) { AF4 res = InputGather(p, 2u); return res; }
+	#define FSR_RCAS_F
+	AF4 FsrRcasLoadF(ASU2 p)
+	{
+		if (SamplePass == SAMPLE_PASS_FUSED)
+			return AF4(FusedTileLoad(p), 1);
+		return texelFetch(sampler2D(InputTexture,InputSampler), ASU2(p), 0);
+	}
+	void FsrRcasInputF(inout AF1 r, inout AF1 g, inout AF1 b) {}
+#else
 	layout(set=0,binding=2,rgba16f) uniform image2D OutputTexture;
-	layout(set=0,binding=3) uniform sampler InputSampler;
-	#if SAMPLE_EASU
-		#define FSR_EASU_H 1
-		AH4 FsrEasuRH(AF2 p) { AH4 res = AH4(textureGather(sampler2D(InputTexture,InputSampler), p, 0)); return res; }
-		AH4 FsrEasuGH(AF2 p) { AH4 res = AH4(textureGather(sampler2D(InputTexture,InputSampler), p, 1)); return res; }
-		AH4 FsrEasuBH(AF2 p) { AH4 res = AH4(textureGather(sampler2D(InputTexture,InputSampler), p, 2)); return res; }	
-	#endif
-	#if SAMPLE_RCAS
-		#define FSR_RCAS_H
-		AH4 FsrRcasLoadH(ASW2 p) { return AH4(texelFetch(sampler2D(InputTexture,InputSampler), ASU2(p), 0)); }
-		void FsrRcasInputH(inout AH1 r,inout AH1 g,inout AH1 b){}
+	#define FSR_EASU_H 1
+	AH4 FsrEasuRH(AF2 p) { AH4 res = AH4(InputGather(p, 0u)); return res; }
+	AH4 FsrEasuGH(AF2 p) { AH4 res = AH4(InputGather(p, 1u)); return res; }
+	AH4 FsrEasuBH(AF2 p) { AH4 res = AH4(InputGather(p, 2u)); return res; }
+	#define FSR_RCAS_H
+	AH4 FsrRcasLoadH(ASW2 p)
+	{
+		if (SamplePass == SAMPLE_PASS_FUSED)
+			return AH4(FusedTileLoad(ASU2(p)), 1);
+		return AH4(texelFetch(sampler2D(InputTexture,InputSampler), ASU2(p), 0));
+	}
+	void FsrRcasInputH(inout AH1 r,inout AH1 g,inout AH1 b){}
+	#if SAMPLE_EASU_HX2
+		#define FSR_EASU_HX2 1
+		AH4 FsrEasuRHx2(AF2 p) { return FsrEasuRH(p); }
+		AH4 FsrEasuGHx2(AF2 p) { return FsrEasuGH(p); }
+		AH4 FsrEasuBHx2(AF2 p) { return FsrEasuBH(p); }
 	#endif
+	#define FSR_RCAS_HX2 1
+	AH4 FsrRcasLoadHx2(ASW2 p) { return AH4(texelFetch(sampler2D(InputTexture,InputSampler), ASU2(p), 0)); }
+	void FsrRcasInputHx2(inout AH2 r,inout AH2 g,inout AH2 b){}
 #endif
 
 #include "ffx_fsr1.h"
 
-void CurrFilter(AU2 pos)
+// Runs EASU over the tile, each lane takes every 64th pixel.
+// Halo pixels outside the image are clamped to the edge, which is what RCAS would see with a clamped load.
+void FusedEasu(AU1 lane)
 {
-#if SAMPLE_BILINEAR
-	AF2 pp = (AF2(pos) * AF2_AU2(Const0.xy) + AF2_AU2(Const0.zw)) * AF2_AU2(Const1.xy) + AF2(0.5, -0.5) * AF2_AU2(Const1.zw);
-	imageStore(OutputTexture, ASU2(pos), textureLod(sampler2D(InputTexture,InputSampler), pp, 0.0));
-#endif
-#if SAMPLE_EASU
+	for (AU1 i = lane; i < FUSED_TILE_DIM * FUSED_TILE_DIM; i += 64u)
+	{
+		ASU2 p = clamp(FusedTileOrigin + ASU2(i % FUSED_TILE_DIM, i / FUSED_TILE_DIM), ASU2(0, 0), ASU2(Const4.zw) - ASU2(1, 1));
 	#if SAMPLE_SLOW_FALLBACK
 		AF3 c;
-		FsrEasuF(c, pos, Const0, Const1, Const2, Const3);
-		if( Sample.x == 1 )
-			c *= c;
-		imageStore(OutputTexture, ASU2(pos), AF4(c, 1));
+		FsrEasuF(c, AU2(p), Const0, Const1, Const2, Const3);
 	#else
-		AH3 c;
-		FsrEasuH(c, pos, Const0, Const1, Const2, Const3);
-		if( Sample.x == 1 )
-			c *= c;
-		imageStore(OutputTexture, ASU2(pos), AH4(c, 1));
+		AH3 h;
+		FsrEasuH(h, AU2(p), Const0, Const1, Const2, Const3);
+		AF3 c = AF3(h);
 	#endif
+		FusedTileR[i] = c.r;
+		FusedTileG[i] = c.g;
+		FusedTileB[i] = c.b;
+	}
+}
+
+void CurrFilter(AU2 pos)
+{
+	if (SamplePass == SAMPLE_PASS_BILINEAR)
+	{
+		AF2 pp = (AF2(pos) * AF2_AU2(Const0.xy) + AF2_AU2(Const0.zw)) * AF2_AU2(Const1.xy) + AF2(0.5, -0.5) * AF2_AU2(Const1.zw);
+		// Past the center of the last texel of the viewport the filter would blend in what lies beyond it.
+		pp = min(pp, InputLimit());
+		AF4 c = textureLod(sampler2D(InputTexture,InputSampler), pp, 0.0);
+		if (SampleHdr)
+			c.rgb *= c.rgb;
+		imageStore(OutputTexture, ASU2(pos), c);
+		return;
+	}
+#if SAMPLE_SLOW_FALLBACK
+	AF3 c;
+	if (SamplePass == SAMPLE_PASS_EASU)
+		FsrEasuF(c, pos, Const0, Const1, Const2, Const3);
+	else
+		FsrRcasF(c.r, c.g, c.b, pos, (SamplePass == SAMPLE_PASS_FUSED) ? Const4 : Const0);
+	if (SampleHdr)
+		c *= c;
+	imageStore(OutputTexture, ASU2(pos), AF4(c, 1));
+#else
+	AH3 c;
+	if (SamplePass == SAMPLE_PASS_EASU)
+		FsrEasuH(c, pos, Const0, Const1, Const2, Const3);
+	else
+		FsrRcasH(c.r, c.g, c.b, pos, (SamplePass == SAMPLE_PASS_FUSED) ? Const4 : Const0);
+	if (SampleHdr)
+		c *= c;
+	imageStore(OutputTexture, ASU2(pos), AH4(c, 1));
 #endif
-#if SAMPLE_RCAS
-	#if SAMPLE_SLOW_FALLBACK
-		AF3 c;
-		FsrRcasF(c.r, c.g, c.b, pos, Const0);
-		if( Sample.x == 1 )
-			c *= c;
-		imageStore(OutputTexture, ASU2(pos), AF4(c, 1));
-	#else
-		AH3 c;
-		FsrRcasH(c.r, c.g, c.b, pos, Const0);
-		if( Sample.x == 1 )
-			c *= c;
-		imageStore(OutputTexture, ASU2(pos), AH4(c, 1));
-	#endif
+}
+
+#if !SAMPLE_SLOW_FALLBACK
+#if SAMPLE_EASU_HX2
+// Packed EASU, one call covers the left and right 8x8 tiles of a 16x8 row.
+void CurrFilterHx2(AU2 pos)
+{
+	AH2 r, g, b;
+	FsrEasuHx2(r, g, b, pos, Const0, Const1, Const2, Const3);
+	if (SampleHdr)
+	{
+		r *= r;
+		g *= g;
+		b *= b;
+	}
+	AH4 c0, c1;
+	FsrEasuDepackHx2(c0, c1, r, g, b);
+	imageStore(OutputTexture, ASU2(pos), AH4(c0.rgb, 1));
+	imageStore(OutputTexture, ASU2(pos) + ASU2(8, 0), AH4(c1.rgb, 1));
+}
 #endif
+
+// Film grain in [-0.5, 0.5) for both lanes (pos and pos + (8, 0)): an integer hash of the pixel and frame,
+// independent of the FsrTepdDitHx2() dither so the two don't correlate.
+AH2 GrainHx2(AU2 pos, AU1 frame)
+{
+	AU2 h = (AU2(pos.x, pos.x + 8u) | AU2_(pos.y << 16u)) ^ AU2_(frame * 0x9e3779b9u);
+	h ^= h >> 16u;
+	h *= 0x7feb352du;
+	h ^= h >> 15u;
+	h *= 0x846ca68bu;
+	h ^= h >> 16u;
+	return AH2(AF2(h >> 8u) * AF2_(1.0 / 16777216.0) - AF2_(0.5));
+}
+
+// Packed RCAS, same layout as CurrFilterHx2().
+// Grain and dither work in linear, the SDR output is treated as gamma 2.0 like FsrTepd*() expects.
+void CurrFilterRcasHx2(AU2 pos)
+{
+	AH2 r, g, b;
+	FsrRcasHx2(r, g, b, pos, Const0);
+	if (SampleHdr || SampleTepd || SampleLfga)
+	{
+		r *= r;
+		g *= g;
+		b *= b;
+	}
+	if (SampleLfga)
+	{
+		// Monochrome grain.
+		AH2 grain = GrainHx2(pos, Sample.y);
+		FsrLfgaHx2(r, g, b, grain, grain, grain, AH1(AF1_AU1(Sample.z)));
+	}
+	if (!SampleHdr && SampleTepd)
+		FsrTepdC8Hx2(r, g, b, FsrTepdDitHx2(pos, Sample.y));
+	else if (!SampleHdr && SampleLfga)
+	{
+		r = sqrt(r);
+		g = sqrt(g);
+		b = sqrt(b);
+	}
+	AH4 c0, c1;
+	FsrRcasDepackHx2(c0, c1, r, g, b);
+	imageStore(OutputTexture, ASU2(pos), AH4(c0.rgb, 1));
+	imageStore(OutputTexture, ASU2(pos) + ASU2(8, 0), AH4(c1.rgb, 1));
 }
+#endif
 
 layout(local_size_x=64) in;
 void main()
 {
+	if (SamplePass == SAMPLE_PASS_FUSED)
+	{
+		FusedTileOrigin = ASU2((gl_WorkGroupID.x << 4u) + Sample.x, gl_WorkGroupID.y << 4u) - ASU2(1, 1);
+		FusedEasu(gl_LocalInvocationID.x);
+		barrier();
+	}
 	// Do remapping of local xy in workgroup for a more PS-like swizzle pattern.
-	AU2 gxy = ARmp8x8(gl_LocalInvocationID.x) + AU2(gl_WorkGroupID.x << 4u, gl_WorkGroupID.y << 4u);
+	AU2 gxy = ARmp8x8(gl_LocalInvocationID.x) + AU2((gl_WorkGroupID.x << 4u) + Sample.x, gl_WorkGroupID.y << 4u);
+#if SAMPLE_EASU_HX2
+	if (SamplePass == SAMPLE_PASS_EASU_HX2)
+	{
+		CurrFilterHx2(gxy);
+		gxy.y += 8u;
+		CurrFilterHx2(gxy);
+		return;
+	}
+#endif
+#if !SAMPLE_SLOW_FALLBACK
+	if (SamplePass == SAMPLE_PASS_RCAS_HX2)
+	{
+		CurrFilterRcasHx2(gxy);
+		gxy.y += 8u;
+		CurrFilterRcasHx2(gxy);
+		return;
+	}
+#endif
 	CurrFilter(gxy);
 	gxy.x += 8u;
 	CurrFilter(gxy);
@@ -122,4 +304,3 @@ void main()
 	gxy.x -= 8u;
 	CurrFilter(gxy);
 }
-
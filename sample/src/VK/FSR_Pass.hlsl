@@ -18,14 +18,37 @@
 // THE SOFTWARE.
 
 
-[[vk::binding(0, 0)]] cbuffer cb : register(b0)
+struct FSRConstants
 {
 	uint4 Const0;
 	uint4 Const1;
 	uint4 Const2;
 	uint4 Const3;
-	uint4 Sample;
+	uint4 Sample; // x: first output column of the dispatch (split screen), yz: packed RCAS frame index and grain amount.
+	uint4 Const4; // Fused pass only: RCAS constants in xy, output size in zw.
+	uint4 Viewport; // EASU / bilinear: xy the coordinate past which a 2x2 footprint leaves the render viewport (float), zw its last texel.
 };
+[[vk::push_constant]] FSRConstants Consts;
+
+// Specialization constants, picked per pipeline by FSR_Filter so the pass and HDR branches fold away.
+// Precision stays a define (SAMPLE_SLOW_FALLBACK) since the fp16 path needs device features the fallback can't declare.
+#define SAMPLE_PASS_BILINEAR 0
+#define SAMPLE_PASS_EASU 1
+#define SAMPLE_PASS_RCAS 2
+#define SAMPLE_PASS_FUSED 3
+#define SAMPLE_PASS_RCAS_HX2 4
+#define SAMPLE_PASS_EASU_HX2 5
+[[vk::constant_id(0)]] const uint SamplePass = SAMPLE_PASS_EASU;
+[[vk::constant_id(1)]] const bool SampleHdr = false;
+// Packed RCAS only: temporal energy preserving dither and film grain, fused into the store.
+[[vk::constant_id(2)]] const bool SampleTepd = false;
+[[vk::constant_id(3)]] const bool SampleLfga = false;
+// EASU passes only: the render viewport is smaller than the input texture, gathers reaching past it are clamped.
+[[vk::constant_id(4)]] const bool SampleClampInput = false;
+// The packed EASU is a module of its own (SAMPLE_EASU_HX2, fp16 only), the other passes don't carry FsrEasuHx2.
+#ifndef SAMPLE_EASU_HX2
+	#define SAMPLE_EASU_HX2 0
+#endif
 
 #define A_GPU 1
 #define A_HLSL 1
@@ -36,82 +59,246 @@
 
 #if SAMPLE_SLOW_FALLBACK
 	#include "ffx_a.h"
-	[[vk::binding(1, 0)]] Texture2D InputTexture : register(t0);
-	[[vk::binding(2, 0)]] RWTexture2D<float4> OutputTexture : register(u0);
-	#if SAMPLE_EASU
-		#define FSR_EASU_F 1
-		AF4 FsrEasuRF(AF2 p) { AF4 res = InputTexture.GatherRed(samLinearClamp, p, int2(0, 0)); return res; }
-		AF4 FsrEasuGF(AF2 p) { AF4 res = InputTexture.GatherGreen(samLinearClamp, p, int2(0, 0)); return res; }
-		AF4 FsrEasuBF(AF2 p) { AF4 res = InputTexture.GatherBlue(samLinearClamp, p, int2(0, 0)); return res; }
-	#endif
-	#if SAMPLE_RCAS
-		#define FSR_RCAS_F
-		AF4 FsrRcasLoadF(ASU2 p) { return InputTexture.Load(int3(ASU2(p), 0)); }
-		void FsrRcasInputF(inout AF1 r, inout AF1 g, inout AF1 b) {}
-	#endif
 #else
 	#define A_HALF
 	#include "ffx_a.h"
-	[[vk::binding(1, 0)]] Texture2D<float4> InputTexture : register(t0);
+#endif
+
+// Fused pass: EASU output of the workgroup's 16x16 region plus a 1 pixel halo, RCAS reads its taps from here.
+#define FUSED_TILE_DIM 18u
+groupshared AF1 FusedTileR[FUSED_TILE_DIM * FUSED_TILE_DIM];
+groupshared AF1 FusedTileG[FUSED_TILE_DIM * FUSED_TILE_DIM];
+groupshared AF1 FusedTileB[FUSED_TILE_DIM * FUSED_TILE_DIM];
+static ASU2 FusedTileOrigin;
+AF3 FusedTileLoad(ASU2 p)
+{
+	AU1 i = AU1(p.x - FusedTileOrigin.x) + AU1(p.y - FusedTileOrigin.y) * FUSED_TILE_DIM;
+	return AF3(FusedTileR[i], FusedTileG[i], FusedTileB[i]);
+}
+
+[[vk::binding(1, 0)]] Texture2D<float4> InputTexture : register(t0);
+
+// The render viewport can be smaller than the input texture (dynamic resolution), what lies past it is left over from other frames.
+// With SampleClampInput a gather whose 2x2 footprint reaches past the last column or row is replaced by four clamped loads,
+// which replicate the edge of the viewport like the sampler does at the edge of the texture. Without it the check folds away.
+AF2 InputLimit() { return AF2_AU2(Consts.Viewport.xy); }
+ASU2 InputMaxTexel() { return ASU2(Consts.Viewport.zw); }
+bool InputGatherInside(AF2 p) { return all(p < InputLimit()); }
+ASU2 InputGatherTexel(AF2 p)
+{
+	AU1 w, h;
+	InputTexture.GetDimensions(w, h);
+	return ASU2(floor(p * AF2(w, h) - AF2_(0.5)));
+}
+AF4 InputGatherClamped(AF2 p, AU1 c)
+{
+	ASU2 t0 = clamp(InputGatherTexel(p), ASU2(0, 0), InputMaxTexel());
+	ASU2 t1 = min(t0 + ASU2(1, 1), InputMaxTexel());
+	// Same order as Gather: (0,1) (1,1) (1,0) (0,0)
+	return AF4(InputTexture.Load(int3(t0.x, t1.y, 0))[c], InputTexture.Load(int3(t1, 0))[c], InputTexture.Load(int3(t1.x, t0.y, 0))[c], InputTexture.Load(int3(t0, 0))[c]);
+}
+AF4 InputGather(AF2 p, AU1 c)
+{
+	if (SampleClampInput && !InputGatherInside(p))
+		return InputGatherClamped(p, c);
+	if (c == 0u)
+		return InputTexture.GatherRed(samLinearClamp, p, int2(0, 0));
+	if (c == 1u)
+		return InputTexture.GatherGreen(samLinearClamp, p, int2(0, 0));
+	return InputTexture.GatherBlue(samLinearClamp, p, int2(0, 0));
+}
+
+#if SAMPLE_SLOW_FALLBACK
 	[[vk::binding(2, 0)]] RWTexture2D<float4> OutputTexture : register(u0);
-	#if SAMPLE_EASU
-		#define FSR_EASU_H 1
-		AH4 FsrEasuRH(AF2 p) { AH4 res = (AH4)InputTexture.GatherRed(samLinearClamp, p, int2(0, 0)); return res; }
-		AH4 FsrEasuGH(AF2 p) { AH4 res = (AH4)InputTexture.GatherGreen(samLinearClamp, p, int2(0, 0)); return res; }
-		AH4 FsrEasuBH(AF2 p) { AH4 res = (AH4)InputTexture.GatherBlue(samLinearClamp, p, int2(0, 0)); return res; }
-	#endif
-	#if SAMPLE_RCAS
-		#define FSR_RCAS_H
-		AH4 FsrRcasLoadH(ASW2 p) { return (AH4)InputTexture.Load(ASW3(ASW2(p), 0)); }
-		void FsrRcasInputH(inout AH1 r,inout AH1 g,inout AH1 b){}
+	#define FSR_EASU_F 1
+	AF4 FsrEasuRF(AF2 p) { AF4 res = InputGather(p, 0u); return res; }
+	AF4 FsrEasuGF(AF2 p) { AF4 res = InputGather(p, 1u); return res; }
+	AF4 FsrEasuBF(AF2 p) { AF4 res = InputGather(p, 2u); return res; }
+	#define FSR_RCAS_F
+	AF4 FsrRcasLoadF(ASU2 p)
+	{
+		if (SamplePass == SAMPLE_PASS_FUSED)
+			return AF4(FusedTileLoad(p), 1);
+		return InputTexture.Load(int3(ASU2(p), 0));
+	}
+	void FsrRcasInputF(inout AF1 r, inout AF1 g, inout AF1 b) {}
+#else
+	[[vk::binding(2, 0)]] RWTexture2D<float4> OutputTexture : register(u0);
+	#define FSR_EASU_H 1
+	AH4 FsrEasuRH(AF2 p) { AH4 res = (AH4)InputGather(p, 0u); return res; }
+	AH4 FsrEasuGH(AF2 p) { AH4 res = (AH4)InputGather(p, 1u); return res; }
+	AH4 FsrEasuBH(AF2 p) { AH4 res = (AH4)InputGather(p, 2u); return res; }
+	#define FSR_RCAS_H
+	AH4 FsrRcasLoadH(ASW2 p)
+	{
+		if (SamplePass == SAMPLE_PASS_FUSED)
+			return AH4(FusedTileLoad(ASU2(p)), 1);
+		return (AH4)InputTexture.Load(ASW3(ASW2(p), 0));
+	}
+	void FsrRcasInputH(inout AH1 r,inout AH1 g,inout AH1 b){}
+	#if SAMPLE_EASU_HX2
+		#define FSR_EASU_HX2 1
+		AH4 FsrEasuRHx2(AF2 p) { return FsrEasuRH(p); }
+		AH4 FsrEasuGHx2(AF2 p) { return FsrEasuGH(p); }
+		AH4 FsrEasuBHx2(AF2 p) { return FsrEasuBH(p); }
 	#endif
+	#define FSR_RCAS_HX2 1
+	AH4 FsrRcasLoadHx2(ASW2 p) { return (AH4)InputTexture.Load(ASW3(p, 0)); }
+	void FsrRcasInputHx2(inout AH2 r,inout AH2 g,inout AH2 b){}
 #endif
 
 #include "ffx_fsr1.h"
 
-void CurrFilter(int2 pos)
+// Runs EASU over the tile, each lane takes every 64th pixel.
+// Halo pixels outside the image are clamped to the edge, which is what RCAS would see with a clamped load.
+void FusedEasu(AU1 lane)
 {
-#if SAMPLE_BILINEAR
-	AF2 pp = (AF2(pos) * AF2_AU2(Const0.xy) + AF2_AU2(Const0.zw)) * AF2_AU2(Const1.xy) + AF2(0.5, -0.5) * AF2_AU2(Const1.zw);
-	OutputTexture[pos] = InputTexture.SampleLevel(samLinearClamp, pp, 0.0);
-#endif
-#if SAMPLE_EASU
+	for (AU1 i = lane; i < FUSED_TILE_DIM * FUSED_TILE_DIM; i += 64u)
+	{
+		ASU2 p = clamp(FusedTileOrigin + ASU2(i % FUSED_TILE_DIM, i / FUSED_TILE_DIM), ASU2(0, 0), ASU2(Consts.Const4.zw) - ASU2(1, 1));
 	#if SAMPLE_SLOW_FALLBACK
 		AF3 c;
-		FsrEasuF(c, pos, Const0, Const1, Const2, Const3);
-		if (Sample.x == 1)
-			c *= c;
-		OutputTexture[pos] = float4(c, 1);
+		FsrEasuF(c, AU2(p), Consts.Const0, Consts.Const1, Consts.Const2, Consts.Const3);
 	#else
-		AH3 c;
-		FsrEasuH(c, pos, Const0, Const1, Const2, Const3);
-		if (Sample.x == 1)
-			c *= c;
-		OutputTexture[pos] = AH4(c, 1);
+		AH3 h;
+		FsrEasuH(h, AU2(p), Consts.Const0, Consts.Const1, Consts.Const2, Consts.Const3);
+		AF3 c = AF3(h);
 	#endif
+		FusedTileR[i] = c.r;
+		FusedTileG[i] = c.g;
+		FusedTileB[i] = c.b;
+	}
+}
+
+void CurrFilter(int2 pos)
+{
+	if (SamplePass == SAMPLE_PASS_BILINEAR)
+	{
+		AF2 pp = (AF2(pos) * AF2_AU2(Consts.Const0.xy) + AF2_AU2(Consts.Const0.zw)) * AF2_AU2(Consts.Const1.xy) + AF2(0.5, -0.5) * AF2_AU2(Consts.Const1.zw);
+		// Past the center of the last texel of the viewport the filter would blend in what lies beyond it.
+		pp = min(pp, InputLimit());
+		AF4 c = InputTexture.SampleLevel(samLinearClamp, pp, 0.0);
+		if (SampleHdr)
+			c.rgb *= c.rgb;
+		OutputTexture[pos] = c;
+		return;
+	}
+#if SAMPLE_SLOW_FALLBACK
+	AF3 c;
+	if (SamplePass == SAMPLE_PASS_EASU)
+		FsrEasuF(c, pos, Consts.Const0, Consts.Const1, Consts.Const2, Consts.Const3);
+	else
+		FsrRcasF(c.r, c.g, c.b, pos, (SamplePass == SAMPLE_PASS_FUSED) ? Consts.Const4 : Consts.Const0);
+	if (SampleHdr)
+		c *= c;
+	OutputTexture[pos] = float4(c, 1);
+#else
+	AH3 c;
+	if (SamplePass == SAMPLE_PASS_EASU)
+		FsrEasuH(c, pos, Consts.Const0, Consts.Const1, Consts.Const2, Consts.Const3);
+	else
+		FsrRcasH(c.r, c.g, c.b, pos, (SamplePass == SAMPLE_PASS_FUSED) ? Consts.Const4 : Consts.Const0);
+	if (SampleHdr)
+		c *= c;
+	OutputTexture[pos] = AH4(c, 1);
 #endif
-#if SAMPLE_RCAS
-	#if SAMPLE_SLOW_FALLBACK
-		AF3 c;
-		FsrRcasF(c.r, c.g, c.b, pos, Const0);
-		if (Sample.x == 1)
-			c *= c;
-		OutputTexture[pos] = float4(c, 1);
-	#else
-		AH3 c;
-		FsrRcasH(c.r, c.g, c.b, pos, Const0);
-		if (Sample.x == 1)
-			c *= c;
-		OutputTexture[pos] = AH4(c, 1);
-	#endif
+}
+
+#if !SAMPLE_SLOW_FALLBACK
+#if SAMPLE_EASU_HX2
+// Packed EASU, one call covers the left and right 8x8 tiles of a 16x8 row.
+void CurrFilterHx2(int2 pos)
+{
+	AH2 r, g, b;
+	FsrEasuHx2(r, g, b, pos, Consts.Const0, Consts.Const1, Consts.Const2, Consts.Const3);
+	if (SampleHdr)
+	{
+		r *= r;
+		g *= g;
+		b *= b;
+	}
+	AH4 c0, c1;
+	FsrEasuDepackHx2(c0, c1, r, g, b);
+	OutputTexture[pos] = AH4(c0.rgb, 1);
+	OutputTexture[pos + int2(8, 0)] = AH4(c1.rgb, 1);
+}
 #endif
+
+// Film grain in [-0.5, 0.5) for both lanes (pos and pos + (8, 0)): an integer hash of the pixel and frame,
+// independent of the FsrTepdDitHx2() dither so the two don't correlate.
+AH2 GrainHx2(AU2 pos, AU1 frame)
+{
+	AU2 h = (AU2(pos.x, pos.x + 8u) | AU2_(pos.y << 16u)) ^ AU2_(frame * 0x9e3779b9u);
+	h ^= h >> 16u;
+	h *= 0x7feb352du;
+	h ^= h >> 15u;
+	h *= 0x846ca68bu;
+	h ^= h >> 16u;
+	return AH2(AF2(h >> 8u) * AF2_(1.0 / 16777216.0) - AF2_(0.5));
 }
 
+// Packed RCAS, same layout as CurrFilterHx2().
+// Grain and dither work in linear, the SDR output is treated as gamma 2.0 like FsrTepd*() expects.
+void CurrFilterRcasHx2(int2 pos)
+{
+	AH2 r, g, b;
+	FsrRcasHx2(r, g, b, pos, Consts.Const0);
+	if (SampleHdr || SampleTepd || SampleLfga)
+	{
+		r *= r;
+		g *= g;
+		b *= b;
+	}
+	if (SampleLfga)
+	{
+		// Monochrome grain.
+		AH2 grain = GrainHx2(AU2(pos), Consts.Sample.y);
+		FsrLfgaHx2(r, g, b, grain, grain, grain, AH1(AF1_AU1(Consts.Sample.z)));
+	}
+	if (!SampleHdr && SampleTepd)
+		FsrTepdC8Hx2(r, g, b, FsrTepdDitHx2(pos, Consts.Sample.y));
+	else if (!SampleHdr && SampleLfga)
+	{
+		r = sqrt(r);
+		g = sqrt(g);
+		b = sqrt(b);
+	}
+	AH4 c0, c1;
+	FsrRcasDepackHx2(c0, c1, r, g, b);
+	OutputTexture[pos] = AH4(c0.rgb, 1);
+	OutputTexture[pos + int2(8, 0)] = AH4(c1.rgb, 1);
+}
+#endif
+
 [numthreads(WIDTH, HEIGHT, DEPTH)]
 void main(uint3 LocalThreadId : SV_GroupThreadID, uint3 WorkGroupId : SV_GroupID, uint3 Dtid : SV_DispatchThreadID)
 {
+	if (SamplePass == SAMPLE_PASS_FUSED)
+	{
+		FusedTileOrigin = ASU2((WorkGroupId.x << 4u) + Consts.Sample.x, WorkGroupId.y << 4u) - ASU2(1, 1);
+		FusedEasu(LocalThreadId.x);
+		GroupMemoryBarrierWithGroupSync();
+	}
 	// Do remapping of local xy in workgroup for a more PS-like swizzle pattern.
-	AU2 gxy = ARmp8x8(LocalThreadId.x) + AU2(WorkGroupId.x << 4u, WorkGroupId.y << 4u);
+	AU2 gxy = ARmp8x8(LocalThreadId.x) + AU2((WorkGroupId.x << 4u) + Consts.Sample.x, WorkGroupId.y << 4u);
+#if SAMPLE_EASU_HX2
+	if (SamplePass == SAMPLE_PASS_EASU_HX2)
+	{
+		CurrFilterHx2(gxy);
+		gxy.y += 8u;
+		CurrFilterHx2(gxy);
+		return;
+	}
+#endif
+#if !SAMPLE_SLOW_FALLBACK
+	if (SamplePass == SAMPLE_PASS_RCAS_HX2)
+	{
+		CurrFilterRcasHx2(gxy);
+		gxy.y += 8u;
+		CurrFilterRcasHx2(gxy);
+		return;
+	}
+#endif
 	CurrFilter(gxy);
 	gxy.x += 8u;
 	CurrFilter(gxy);
@@ -120,4 +307,3 @@ void main(uint3 LocalThreadId : SV_GroupThreadID, uint3 WorkGroupId : SV_GroupID
 	gxy.x -= 8u;
 	CurrFilter(gxy);
 }
-
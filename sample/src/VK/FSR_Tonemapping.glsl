@@ -41,6 +41,7 @@ layout (std140, binding = 0) uniform perBatch
     int u_height;
     int u_hdr;
     int u_frame;
+    vec2 u_uvScale; // viewport / texture size, less than 1 with dynamic resolution
 } myPerScene;
 
 layout(set=0, binding=1) uniform sampler2D sSampler[2]; //0 - HDR color input; 1 - temporal blue noise
@@ -65,11 +66,11 @@ void main()
 {
     if (myPerScene.u_exposure<0)
     {
-        outColor = texture(sSampler[0], inTexCoord.st);
+        outColor = texture(sSampler[0], inTexCoord.st * myPerScene.u_uvScale);
         return;
     }
 
-    vec4 texColor = texture(sSampler[0], inTexCoord.st);
+    vec4 texColor = texture(sSampler[0], inTexCoord.st * myPerScene.u_uvScale);
 
     vec3 color = Tonemap(texColor.rgb, myPerScene.u_exposure, myPerScene.u_toneMapper);
     if (myPerScene.u_hdr == 1) //HDR
@@ -20,14 +20,16 @@
 #include "stdafx.h"
 
 #include "SampleRenderer.h"
+#include <future>
 
 //--------------------------------------------------------------------------------------
 //
 // OnCreate
 //
 //--------------------------------------------------------------------------------------
-void SampleRenderer::OnCreate(Device *pDevice, SwapChain *pSwapChain, float fontSize, bool glsl)
+void SampleRenderer::OnCreate(Device *pDevice, SwapChain *pSwapChain, float fontSize, bool glsl, bool parallelCreate)
 {
+    double start = MillisecondsNow();
     m_pDevice = pDevice;
 
     // Initialize helpers
@@ -84,15 +86,44 @@ void SampleRenderer::OnCreate(Device *pDevice, SwapChain *pSwapChain, float font
     }
 
     // Create a 2Kx2K Shadowmap atlas to hold 4 cascades/spotlights
-    m_shadowMap.InitDepthStencil(m_pDevice, 2 * 1024, 2 * 1024, VK_FORMAT_D32_SFLOAT, VK_SAMPLE_COUNT_1_BIT, "ShadowMap");
-    m_shadowMap.CreateSRV(&m_shadowMapSRV);
-    m_shadowMap.CreateDSV(&m_shadowMapDSV);
+    // It is dead once the G-buffer is lit, so the render output and the FSR intermediary can reuse its memory later in the frame.
+    m_transientAllocator.OnCreate(pDevice);
+    {
+        VkImageCreateInfo image_info = {};
+        image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        image_info.imageType = VK_IMAGE_TYPE_2D;
+        image_info.format = VK_FORMAT_D32_SFLOAT;
+        image_info.extent.width = shadowMapSize;
+        image_info.extent.height = shadowMapSize;
+        image_info.extent.depth = 1;
+        image_info.mipLevels = 1;
+        image_info.arrayLayers = 1;
+        image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+        image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+        image_info.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        m_shadowMap = m_transientAllocator.CreatePersistentImage(image_info, TransientAllocator::PASS_SHADOW, TransientAllocator::PASS_GBUFFER, "ShadowMap");
+
+        VkImageViewCreateInfo view_info = {};
+        view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        view_info.image = m_shadowMap;
+        view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        view_info.format = VK_FORMAT_D32_SFLOAT;
+        view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+        view_info.subresourceRange.levelCount = 1;
+        view_info.subresourceRange.layerCount = 1;
+        VkResult res = vkCreateImageView(m_pDevice->GetDevice(), &view_info, NULL, &m_shadowMapSRV);
+        assert(res == VK_SUCCESS);
+        res = vkCreateImageView(m_pDevice->GetDevice(), &view_info, NULL, &m_shadowMapDSV);
+        assert(res == VK_SUCCESS);
+    }
 
     // Create render pass shadow, will clear contents
     //
     {
         VkAttachmentDescription depthAttachments;
-        AttachClearBeforeUse(m_shadowMap.GetFormat(), VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, &depthAttachments);
+        AttachClearBeforeUse(VK_FORMAT_D32_SFLOAT, VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, &depthAttachments);
         m_render_pass_shadow = CreateRenderPassOptimal(m_pDevice->GetDevice(), 0, NULL, &depthAttachments);
 
         // Create frame buffer, its size is now window dependant so we can do this here.
@@ -104,36 +135,81 @@ void SampleRenderer::OnCreate(Device *pDevice, SwapChain *pSwapChain, float font
         fb_info.renderPass = m_render_pass_shadow;
         fb_info.attachmentCount = 1;
         fb_info.pAttachments = attachmentViews;
-        fb_info.width = m_shadowMap.GetWidth();
-        fb_info.height = m_shadowMap.GetHeight();
+        fb_info.width = shadowMapSize;
+        fb_info.height = shadowMapSize;
         fb_info.layers = 1;
         VkResult res = vkCreateFramebuffer(m_pDevice->GetDevice(), &fb_info, NULL, &m_pFrameBuffer_shadow);
         assert(res == VK_SUCCESS);
     }
 
-    m_skyDome.OnCreate(pDevice, m_renderPassJustDepthAndHdr.GetRenderPass(), &m_UploadHeap, VK_FORMAT_R16G16B16A16_SFLOAT, &m_resourceViewHeaps, &m_ConstantBufferRing, &m_VidMemBufferPool, "..\\media\\cauldron-media\\envmaps\\papermill\\diffuse.dds", "..\\media\\cauldron-media\\envmaps\\papermill\\specular.dds", VK_SAMPLE_COUNT_1_BIT);
-    m_skyDomeProc.OnCreate(pDevice, m_renderPassJustDepthAndHdr.GetRenderPass(), &m_UploadHeap, VK_FORMAT_R16G16B16A16_SFLOAT, &m_resourceViewHeaps, &m_ConstantBufferRing, &m_VidMemBufferPool, VK_SAMPLE_COUNT_1_BIT);
-    m_wireframe.OnCreate(pDevice, m_renderPassJustDepthAndHdr.GetRenderPass(), &m_resourceViewHeaps, &m_ConstantBufferRing, &m_VidMemBufferPool, VK_SAMPLE_COUNT_1_BIT);
-    m_wireframeBox.OnCreate(pDevice, &m_resourceViewHeaps, &m_ConstantBufferRing, &m_VidMemBufferPool);
-    m_downSample.OnCreate(pDevice, &m_resourceViewHeaps, &m_ConstantBufferRing, &m_VidMemBufferPool, VK_FORMAT_R16G16B16A16_SFLOAT);
-    m_bloom.OnCreate(pDevice, &m_resourceViewHeaps, &m_ConstantBufferRing, &m_VidMemBufferPool, VK_FORMAT_R16G16B16A16_SFLOAT);
-    m_TAA.OnCreate(pDevice, &m_resourceViewHeaps, &m_VidMemBufferPool, &m_ConstantBufferRing, false);
-	m_FSR.OnCreate(pDevice, &m_resourceViewHeaps, &m_ConstantBufferRing, glsl);
-    m_magnifierPS.OnCreate(pDevice, &m_resourceViewHeaps, &m_ConstantBufferRing, &m_VidMemBufferPool, VK_FORMAT_R16G16B16A16_SFLOAT);
+    // The passes only need the render passes above and otherwise share the descriptor heaps and the static buffer pool, which lock,
+    // so each one compiles its shaders and creates its pipelines on the pool. The shader cache makes concurrent compiles of the same
+    // source wait for each other. The sky domes and the UI get m_UploadHeap, which submits, and stay on this thread.
+    AsyncPool *pAsyncPool = parallelCreate ? &m_asyncPool : NULL;
+    ExecAsyncIfThereIsAPool(pAsyncPool, [=]() { m_wireframe.OnCreate(pDevice, m_renderPassJustDepthAndHdr.GetRenderPass(), &m_resourceViewHeaps, &m_ConstantBufferRing, &m_VidMemBufferPool, VK_SAMPLE_COUNT_1_BIT); });
+    ExecAsyncIfThereIsAPool(pAsyncPool, [=]() { m_wireframeBox.OnCreate(pDevice, &m_resourceViewHeaps, &m_ConstantBufferRing, &m_VidMemBufferPool); });
+    ExecAsyncIfThereIsAPool(pAsyncPool, [=]() { m_downSample.OnCreate(pDevice, &m_resourceViewHeaps, &m_ConstantBufferRing, &m_VidMemBufferPool, VK_FORMAT_R16G16B16A16_SFLOAT); });
+    ExecAsyncIfThereIsAPool(pAsyncPool, [=]() { m_bloom.OnCreate(pDevice, &m_resourceViewHeaps, &m_ConstantBufferRing, &m_VidMemBufferPool, VK_FORMAT_R16G16B16A16_SFLOAT); });
+    ExecAsyncIfThereIsAPool(pAsyncPool, [=]() { m_TAA.OnCreate(pDevice, &m_resourceViewHeaps, &m_VidMemBufferPool, &m_ConstantBufferRing, false); });
+    ExecAsyncIfThereIsAPool(pAsyncPool, [=]() { m_magnifierPS.OnCreate(pDevice, &m_resourceViewHeaps, &m_ConstantBufferRing, &m_VidMemBufferPool, VK_FORMAT_R16G16B16A16_SFLOAT); });
 
     // Create tonemapping pass
-    m_toneMappingCS.OnCreate(pDevice, &m_resourceViewHeaps, &m_ConstantBufferRing);
-    m_toneMappingPS.OnCreate(m_pDevice, pSwapChain->GetRenderPass(), &m_resourceViewHeaps, &m_VidMemBufferPool, &m_ConstantBufferRing, 2, "FSR_Tonemapping.glsl");
-    m_colorConversionPS.OnCreate(pDevice, pSwapChain->GetRenderPass(), &m_resourceViewHeaps, &m_VidMemBufferPool, &m_ConstantBufferRing);
+    ExecAsyncIfThereIsAPool(pAsyncPool, [=]() { m_toneMappingCS.OnCreate(pDevice, &m_resourceViewHeaps, &m_ConstantBufferRing); });
+    ExecAsyncIfThereIsAPool(pAsyncPool, [=]() { m_toneMappingPS.OnCreate(m_pDevice, pSwapChain->GetRenderPass(), &m_resourceViewHeaps, &m_VidMemBufferPool, &m_ConstantBufferRing, 2, "FSR_Tonemapping.glsl"); });
+    ExecAsyncIfThereIsAPool(pAsyncPool, [=]() { m_colorConversionPS.OnCreate(pDevice, pSwapChain->GetRenderPass(), &m_resourceViewHeaps, &m_VidMemBufferPool, &m_ConstantBufferRing); });
+
+    // FSR adds a job per precision itself
+	m_FSR.OnCreate(pDevice, &m_resourceViewHeaps, glsl, pAsyncPool);
+	m_asyncCompute.OnCreate(pDevice, backBufferCount);
+
+    m_skyDomeProc.OnCreate(pDevice, m_renderPassJustDepthAndHdr.GetRenderPass(), &m_UploadHeap, VK_FORMAT_R16G16B16A16_SFLOAT, &m_resourceViewHeaps, &m_ConstantBufferRing, &m_VidMemBufferPool, VK_SAMPLE_COUNT_1_BIT);
+    m_skyDome.OnCreate(pDevice, m_renderPassJustDepthAndHdr.GetRenderPass(), &m_UploadHeap, VK_FORMAT_R16G16B16A16_SFLOAT, &m_resourceViewHeaps, &m_ConstantBufferRing, &m_VidMemBufferPool, "..\\media\\cauldron-media\\envmaps\\papermill\\diffuse.dds", "..\\media\\cauldron-media\\envmaps\\papermill\\specular.dds", VK_SAMPLE_COUNT_1_BIT);
 
     // Initialize UI rendering resources
     m_ImGUI.OnCreate(m_pDevice, pSwapChain->GetRenderPass(), &m_UploadHeap, &m_ConstantBufferRing, fontSize);
+
+    for (uint32_t slot = 0; slot < s_parallelSlots; slot++)
+    {
+        for (uint32_t pass = 0; pass < PARALLEL_PASS_COUNT; pass++)
+        {
+            VkCommandPoolCreateInfo poolInfo = {};
+            poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            poolInfo.queueFamilyIndex = pDevice->GetGraphicsQueueFamilyIndex();
+            VkResult res = vkCreateCommandPool(pDevice->GetDevice(), &poolInfo, NULL, &m_parallelPools[slot][pass]);
+            assert(res == VK_SUCCESS);
+
+            VkCommandBufferAllocateInfo allocInfo = {};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.commandPool = m_parallelPools[slot][pass];
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandBufferCount = 1;
+            res = vkAllocateCommandBuffers(pDevice->GetDevice(), &allocInfo, &m_parallelCmdBufs[slot][pass]);
+            assert(res == VK_SUCCESS);
+        }
+    }
+
+    m_hiddenWindowFences.resize(backBufferCount);
+    for (VkFence& fence : m_hiddenWindowFences)
+    {
+        VkFenceCreateInfo fence_ci = {};
+        fence_ci.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        fence_ci.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+        VkResult res = vkCreateFence(pDevice->GetDevice(), &fence_ci, NULL, &fence);
+        assert(res == VK_SUCCESS);
+    }
     m_blueNoise.InitFromFile(pDevice, &m_UploadHeap, "..\\media\\cauldron-media\\noise\\temporal_blue_noise.dds");
     m_blueNoise.CreateSRV(&m_blueNoiseSRV);
 
+    // The passes on the pool may still be filling m_VidMemBufferPool
+    m_asyncPool.Flush();
+
     // Make sure upload heap has finished uploading before continuing
     m_VidMemBufferPool.UploadData(m_UploadHeap.GetCommandList());
     m_UploadHeap.FlushAndFinish();
+
+    m_createTime = (float)(MillisecondsNow() - start);
+    Trace(format("SampleRenderer::OnCreate: %.1f ms (%s)\n", m_createTime, parallelCreate ? "parallel" : "serial"));
 }
 
 //--------------------------------------------------------------------------------------
@@ -150,6 +226,7 @@ void SampleRenderer::OnDestroy()
     m_toneMappingPS.OnDestroy();
     m_toneMappingCS.OnDestroy();
 	m_FSR.OnDestroy();
+	m_asyncCompute.OnDestroy();
     m_TAA.OnDestroy();
     m_bloom.OnDestroy();
     m_downSample.OnDestroy();
@@ -158,7 +235,6 @@ void SampleRenderer::OnDestroy()
     m_wireframe.OnDestroy();
     m_skyDomeProc.OnDestroy();
     m_skyDome.OnDestroy();
-    m_shadowMap.OnDestroy();
 
     m_renderPassFullGBufferWithClear.OnDestroy();
     m_renderPassJustDepthAndHdr.OnDestroy();
@@ -167,6 +243,7 @@ void SampleRenderer::OnDestroy()
 
     vkDestroyImageView(m_pDevice->GetDevice(), m_shadowMapDSV, nullptr);
     vkDestroyImageView(m_pDevice->GetDevice(), m_shadowMapSRV, nullptr);
+    m_transientAllocator.OnDestroy();
     vkDestroyImageView(m_pDevice->GetDevice(), m_blueNoiseSRV, nullptr);
     
     vkDestroyRenderPass(m_pDevice->GetDevice(), m_render_pass_shadow, nullptr);
@@ -179,6 +256,20 @@ void SampleRenderer::OnDestroy()
     m_ConstantBufferRing.OnDestroy();
     m_resourceViewHeaps.OnDestroy();
     m_CommandListRing.OnDestroy();    
+
+    for (VkFence fence : m_hiddenWindowFences)
+        vkDestroyFence(m_pDevice->GetDevice(), fence, NULL);
+    m_hiddenWindowFences.clear();
+
+    for (uint32_t slot = 0; slot < s_parallelSlots; slot++)
+    {
+        for (uint32_t pass = 0; pass < PARALLEL_PASS_COUNT; pass++)
+        {
+            vkDestroyCommandPool(m_pDevice->GetDevice(), m_parallelPools[slot][pass], NULL);
+            m_parallelPools[slot][pass] = VK_NULL_HANDLE;
+            m_parallelCmdBufs[slot][pass] = VK_NULL_HANDLE;
+        }
+    }
 }
 
 //--------------------------------------------------------------------------------------
@@ -190,19 +281,19 @@ void SampleRenderer::OnCreateWindowSizeDependentResources(SwapChain *pSwapChain,
 {
     // Create GBuffer
     //
-    m_GBuffer.OnCreateWindowSizeDependentResources(pSwapChain, pState->renderWidth, pState->renderHeight);
+    m_GBuffer.OnCreateWindowSizeDependentResources(pSwapChain, pState->renderTargetWidth, pState->renderTargetHeight);
 
     // Create frame buffers for the GBuffer render passes
     //
-    m_renderPassFullGBufferWithClear.OnCreateWindowSizeDependentResources(pState->renderWidth, pState->renderHeight);
-    m_renderPassJustDepthAndHdr.OnCreateWindowSizeDependentResources(pState->renderWidth, pState->renderHeight);
-    m_renderPassFullGBuffer.OnCreateWindowSizeDependentResources(pState->renderWidth, pState->renderHeight);
+    m_renderPassFullGBufferWithClear.OnCreateWindowSizeDependentResources(pState->renderTargetWidth, pState->renderTargetHeight);
+    m_renderPassJustDepthAndHdr.OnCreateWindowSizeDependentResources(pState->renderTargetWidth, pState->renderTargetHeight);
+    m_renderPassFullGBuffer.OnCreateWindowSizeDependentResources(pState->renderTargetWidth, pState->renderTargetHeight);
 
     // Update PostProcessing passes
     //
-    m_downSample.OnCreateWindowSizeDependentResources(pState->renderWidth, pState->renderHeight, &m_GBuffer.m_HDR, 1);
-    m_bloom.OnCreateWindowSizeDependentResources(pState->renderWidth / 2, pState->renderHeight / 2, m_downSample.GetTexture(), 1, &m_GBuffer.m_HDR);
-    m_TAA.OnCreateWindowSizeDependentResources(pState->renderWidth, pState->renderHeight, &m_GBuffer);
+    m_downSample.OnCreateWindowSizeDependentResources(pState->renderTargetWidth, pState->renderTargetHeight, &m_GBuffer.m_HDR, 1);
+    m_bloom.OnCreateWindowSizeDependentResources(pState->renderTargetWidth / 2, pState->renderTargetHeight / 2, m_downSample.GetTexture(), 1, &m_GBuffer.m_HDR);
+    m_TAA.OnCreateWindowSizeDependentResources(pState->renderTargetWidth, pState->renderTargetHeight, &m_GBuffer);
     
     bool hdr = (pSwapChain->GetDisplayMode() != DISPLAYMODE_SDR);
     VkFormat uiFormat = (hdr ? m_GBuffer.m_HDR.GetFormat() : pSwapChain->GetFormat());
@@ -212,9 +303,43 @@ void SampleRenderer::OnCreateWindowSizeDependentResources(SwapChain *pSwapChain,
     //
     m_colorConversionPS.UpdatePipelines(pSwapChain->GetRenderPass(), pSwapChain->GetDisplayMode());
 
-	m_renderOutput.InitRenderTarget(m_pDevice, pState->renderWidth, pState->renderHeight, rFormat, VK_SAMPLE_COUNT_1_BIT, (VkImageUsageFlags)(VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT), false, "RenderOutput", VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT);
-    VkImageView rortv, dortv, mortv;
-    m_renderOutput.CreateRTV(&rortv);
+    // Written by tonemapping, read by EASU and once more by the fused comparison after RCAS.
+    VkResult res;
+    {
+        VkImageCreateInfo image_info = {};
+        image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        image_info.flags = VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT;
+        image_info.imageType = VK_IMAGE_TYPE_2D;
+        image_info.format = rFormat;
+        image_info.extent.width = pState->renderTargetWidth;
+        image_info.extent.height = pState->renderTargetHeight;
+        image_info.extent.depth = 1;
+        image_info.mipLevels = 1;
+        image_info.arrayLayers = 1;
+        image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+        image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+        image_info.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        m_renderOutput = m_transientAllocator.CreateImage(image_info, TransientAllocator::PASS_TONEMAP, TransientAllocator::PASS_RCAS, "RenderOutput");
+    }
+    m_FSR.CreateIntermediary(&m_transientAllocator, displayWidth, displayHeight, hdr);
+    // Everything is declared, place it before any view gets created.
+    // The async upscale uses both images on the compute queue, where the aliasing barriers of the graphics queue don't reach.
+    m_transientAllocator.Allocate(!(pState->bUseAsyncCompute && m_asyncCompute.IsSupported()));
+    {
+        VkImageViewCreateInfo view_info = {};
+        view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        view_info.image = m_renderOutput;
+        view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        view_info.format = rFormat;
+        view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        view_info.subresourceRange.levelCount = 1;
+        view_info.subresourceRange.layerCount = 1;
+        res = vkCreateImageView(m_pDevice->GetDevice(), &view_info, NULL, &m_renderOutputRTV);
+        assert(res == VK_SUCCESS);
+    }
+    VkImageView dortv, mortv;
     VkAttachmentDescription atd = {};
     atd.format = rFormat;
     atd.samples = VK_SAMPLE_COUNT_1_BIT;
@@ -229,11 +354,11 @@ void SampleRenderer::OnCreateWindowSizeDependentResources(SwapChain *pSwapChain,
     fb_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
     fb_info.renderPass = m_renderOutputRenderPass;
     fb_info.attachmentCount = 1;
-    fb_info.pAttachments = &rortv;
-    fb_info.width = pState->renderWidth;
-    fb_info.height = pState->renderHeight;
+    fb_info.pAttachments = &m_renderOutputRTV;
+    fb_info.width = pState->renderTargetWidth;
+    fb_info.height = pState->renderTargetHeight;
     fb_info.layers = 1;
-    VkResult res = vkCreateFramebuffer(m_pDevice->GetDevice(), &fb_info, NULL, &m_renderOutputFramebuffer);
+    res = vkCreateFramebuffer(m_pDevice->GetDevice(), &fb_info, NULL, &m_renderOutputFramebuffer);
     assert(res == VK_SUCCESS);
 	m_displayOutput.InitRenderTarget(m_pDevice, displayWidth, displayHeight, dFormat, VK_SAMPLE_COUNT_1_BIT, (VkImageUsageFlags)(VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT), false, "DisplayOutput", VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT);
     m_magnifierPS.OnCreateWindowSizeDependentResources(&m_displayOutput);
@@ -260,7 +385,7 @@ void SampleRenderer::OnCreateWindowSizeDependentResources(SwapChain *pSwapChain,
     atd.initialLayout = VK_IMAGE_LAYOUT_GENERAL;
     m_displayOutputGuiRenderPass = CreateRenderPassOptimal(m_pDevice->GetDevice(), 1, &atd, 0);
     m_ImGUI.UpdatePipeline(m_displayOutputGuiRenderPass);
-    m_FSR.OnCreateWindowSizeDependentResources(m_pDevice, m_renderOutput.Resource(), m_displayOutput.Resource(), dFormat, displayWidth, displayHeight, pState, hdr);
+    m_FSR.OnCreateWindowSizeDependentResources(m_pDevice, m_renderOutput, m_displayOutput.Resource(), dFormat, displayWidth, displayHeight, pState, hdr);
     if( pState->m_nUpscaleType == 2 )
         m_toneMappingPS.UpdatePipelines(m_displayOutputRenderPass);
     else
@@ -300,8 +425,9 @@ void SampleRenderer::OnDestroyWindowSizeDependentResources()
     vkDestroyFramebuffer(m_pDevice->GetDevice(), m_displayOutputFramebuffer, nullptr);
     vkDestroyFramebuffer(m_pDevice->GetDevice(), m_magnifierFramebuffer, nullptr);
     vkDestroyImageView(m_pDevice->GetDevice(), m_displayOutputSRV, nullptr);
+    vkDestroyImageView(m_pDevice->GetDevice(), m_renderOutputRTV, nullptr);
     m_displayOutput.OnDestroy();
-    m_renderOutput.OnDestroy();
+    m_transientAllocator.Release();
 }
 
 //--------------------------------------------------------------------------------------
@@ -326,7 +452,7 @@ int SampleRenderer::LoadScene(GLTFCommon *pGLTFCommon, int stage)
     ImGui::OpenPopup("Loading");
     if (ImGui::BeginPopupModal("Loading", NULL, ImGuiWindowFlags_AlwaysAutoResize))
     {
-        float progress = (float)stage / 12.0f;
+        float progress = (float)stage / 6.0f;
         ImGui::ProgressBar(progress, ImVec2(0.f, 0.f), NULL);
         ImGui::EndPopup();
     } 
@@ -334,19 +460,20 @@ int SampleRenderer::LoadScene(GLTFCommon *pGLTFCommon, int stage)
     // use multithreading
     AsyncPool *pAsyncPool = &m_asyncPool;
 
-    // Loading stages
+    // Loading stages, one per frame. Stage 0 only shows the progress bar, e.g. while the glTF is still being parsed.
+    // The textures are decoded in parallel on the pool, the passes created after them share a single upload and flush at the end.
     //
     if (stage == 0)
     {
     }
-    else if (stage == 5)
+    else if (stage == 1)
     {   
         Profile p("m_pGltfLoader->Load");
         
         m_pGLTFTexturesAndBuffers = new GLTFTexturesAndBuffers();
         m_pGLTFTexturesAndBuffers->OnCreate(m_pDevice, pGLTFCommon, &m_UploadHeap, &m_VidMemBufferPool, &m_ConstantBufferRing);
     }
-    else if (stage == 6)
+    else if (stage == 2)
     {
         Profile p("LoadTextures");
 
@@ -354,7 +481,7 @@ int SampleRenderer::LoadScene(GLTFCommon *pGLTFCommon, int stage)
         // this data will be used to create the PBR and Depth passes       
         m_pGLTFTexturesAndBuffers->LoadTextures(pAsyncPool);
     }
-    else if (stage == 7)
+    else if (stage == 3)
     {
         Profile p("m_gltfDepth->OnCreate");
 
@@ -370,11 +497,8 @@ int SampleRenderer::LoadScene(GLTFCommon *pGLTFCommon, int stage)
             m_pGLTFTexturesAndBuffers,
             pAsyncPool
         );
-
-        m_VidMemBufferPool.UploadData(m_UploadHeap.GetCommandList());
-        m_UploadHeap.FlushAndFinish();
     }
-    else if (stage == 8)
+    else if (stage == 4)
     {
         Profile p("m_gltfPBR->OnCreate");
 
@@ -393,11 +517,8 @@ int SampleRenderer::LoadScene(GLTFCommon *pGLTFCommon, int stage)
             &m_renderPassFullGBufferWithClear,
             pAsyncPool
         );
-
-        m_VidMemBufferPool.UploadData(m_UploadHeap.GetCommandList());
-        m_UploadHeap.FlushAndFinish();
     }
-    else if (stage == 9)
+    else if (stage == 5)
     {
         Profile p("m_gltfBBox->OnCreate");
 
@@ -413,11 +534,11 @@ int SampleRenderer::LoadScene(GLTFCommon *pGLTFCommon, int stage)
             &m_wireframe
         );
 
-        // we are borrowing the upload heap command list for uploading to the GPU the IBs and VBs
+        // we are borrowing the upload heap command list for uploading to the GPU the IBs and VBs of all the passes
         m_VidMemBufferPool.UploadData(m_UploadHeap.GetCommandList());
 
     }
-    else if (stage == 10)
+    else if (stage == 6)
     {
         Profile p("Flush");
 
@@ -474,6 +595,25 @@ void SampleRenderer::UnloadScene()
     }
 }
 
+static void BeginCommandBuffer(VkCommandBuffer cmdBuf)
+{
+    VkCommandBufferBeginInfo cmd_buf_info;
+    cmd_buf_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    cmd_buf_info.pNext = NULL;
+    cmd_buf_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    cmd_buf_info.pInheritanceInfo = NULL;
+    VkResult res = vkBeginCommandBuffer(cmdBuf, &cmd_buf_info);
+    assert(res == VK_SUCCESS);
+}
+
+VkCommandBuffer SampleRenderer::BeginParallelCommandBuffer(uint32_t slot, ParallelPass pass)
+{
+    VkResult res = vkResetCommandPool(m_pDevice->GetDevice(), m_parallelPools[slot][pass], 0);
+    assert(res == VK_SUCCESS);
+    BeginCommandBuffer(m_parallelCmdBufs[slot][pass]);
+    return m_parallelCmdBufs[slot][pass];
+}
+
 //--------------------------------------------------------------------------------------
 //
 // OnRender
@@ -488,20 +628,14 @@ void SampleRenderer::OnRender(int displayWidth, int displayHeight, State *pState
     // command buffer calls
     //    
     VkCommandBuffer cmdBuf1 = m_CommandListRing.GetNewCommandList();
-
-    {
-        VkCommandBufferBeginInfo cmd_buf_info;
-        cmd_buf_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-        cmd_buf_info.pNext = NULL;
-        cmd_buf_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-        cmd_buf_info.pInheritanceInfo = NULL;
-        VkResult res = vkBeginCommandBuffer(cmdBuf1, &cmd_buf_info);
-        assert(res == VK_SUCCESS);
-    }
+    BeginCommandBuffer(cmdBuf1);
 
     m_GPUTimer.OnBeginFrame(cmdBuf1, &m_TimeStamps);
+	m_asyncCompute.OnBeginFrame(cmdBuf1, &m_GPUTimer);
 
-    if (pState->bUseTAA)
+    // TAA works on whole targets and keeps its history at a fixed size, it can't follow a viewport that is smaller or changes every frame.
+    bool taa = pState->bUseTAA && !pState->bDynamicResolution && pState->renderWidth == pState->renderTargetWidth && pState->renderHeight == pState->renderTargetHeight;
+    if (taa)
     {
         static uint32_t Seed;
         pState->camera.SetProjectionJitter(pState->renderWidth, pState->renderHeight, Seed);
@@ -545,32 +679,64 @@ void SampleRenderer::OnRender(int displayWidth, int displayHeight, State *pState
         m_pGLTFTexturesAndBuffers->SetPerFrameConstants();
         m_pGLTFTexturesAndBuffers->SetSkinningMatricesForSkeletons();
     }
+
+    // The PBR batch lists only record, BuildBatchLists() already allocated their constants from the ring, which isn't thread safe.
+    // Workers record them while this thread does the shadow maps and the sky dome, which do allocate, then everything is submitted in frame order.
+    // Timestamps are only written from this thread, the one of a worker's pass goes at the start of the command buffer after it.
+    double recordStart = MillisecondsNow();
+    VkRect2D renderArea = { 0, 0, pState->renderWidth, pState->renderHeight };
+    std::vector<GltfPbrPass::BatchList> opaque, transparent;
+    VkCommandBuffer cmdOpaque = VK_NULL_HANDLE, cmdTransparent = VK_NULL_HANDLE;
+    std::future<void> opaqueRecorded, transparentRecorded;
+    if (pPerFrame != NULL && m_gltfPBR)
+    {
+        m_gltfPBR->BuildBatchLists(&opaque, &transparent);
+        std::sort(transparent.begin(), transparent.end());
+
+        uint32_t slot = m_parallelFrame++ % s_parallelSlots;
+        cmdOpaque = BeginParallelCommandBuffer(slot, PARALLEL_OPAQUE);
+        cmdTransparent = BeginParallelCommandBuffer(slot, PARALLEL_TRANSPARENT);
+        // Deferred runs them on this thread when they are waited for, the serial reference
+        std::launch policy = pState->bParallelRecording ? std::launch::async : std::launch::deferred;
+        opaqueRecorded = std::async(policy, [this, cmdOpaque, renderArea, &opaque]()
+        {
+            m_renderPassFullGBufferWithClear.BeginPass(cmdOpaque, renderArea);
+            m_gltfPBR->DrawBatchList(cmdOpaque, &opaque);
+            m_renderPassFullGBufferWithClear.EndPass(cmdOpaque);
+            VkResult res = vkEndCommandBuffer(cmdOpaque);
+            assert(res == VK_SUCCESS);
+        });
+        transparentRecorded = std::async(policy, [this, cmdTransparent, renderArea, &transparent]()
+        {
+            m_renderPassFullGBuffer.BeginPass(cmdTransparent, renderArea);
+            m_gltfPBR->DrawBatchList(cmdTransparent, &transparent);
+            m_renderPassFullGBuffer.EndPass(cmdTransparent);
+            VkResult res = vkEndCommandBuffer(cmdTransparent);
+            assert(res == VK_SUCCESS);
+        });
+    }
+
+    // This thread's command buffers and the workers', in submission order
+    std::vector<VkCommandBuffer> cmdBufs;
+    auto continueAfter = [&](VkCommandBuffer recorded)
+    {
+        VkResult res = vkEndCommandBuffer(cmdBuf1);
+        assert(res == VK_SUCCESS);
+        cmdBufs.push_back(cmdBuf1);
+        cmdBufs.push_back(recorded);
+        cmdBuf1 = m_CommandListRing.GetNewCommandList();
+        BeginCommandBuffer(cmdBuf1);
+    };
+
     bool renderNative = (pState->m_nUpscaleType == 2);
-	{
-		VkImageMemoryBarrier barrier[3] = {};
-		barrier[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-		barrier[0].srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
-		barrier[0].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-		barrier[0].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		barrier[0].newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-		barrier[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		barrier[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		barrier[0].subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		barrier[0].subresourceRange.baseMipLevel = 0;
-		barrier[0].subresourceRange.levelCount = 1;
-		barrier[0].subresourceRange.baseArrayLayer = 0;
-		barrier[0].subresourceRange.layerCount = 1;
-		barrier[0].image = m_renderOutput.Resource();
-		barrier[1] = barrier[0];
-		barrier[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		barrier[1].newLayout = VK_IMAGE_LAYOUT_GENERAL;
-		barrier[1].image = m_displayOutput.Resource();
-		barrier[2] = barrier[0];
-		barrier[2].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		barrier[2].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-		barrier[2].image = pSwapChain->GetCurrentBackBuffer();
-		vkCmdPipelineBarrier(cmdBuf1, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, NULL, 0, NULL, 3, barrier);
-	}
+
+    // The shadow map may share memory with the previous frame's render output and FSR intermediary: tonemapping wrote the first,
+    // EASU / RCAS read and wrote both on this queue (with async compute nothing is aliased).
+    m_transientAllocator.AliasingBarrier(cmdBuf1,
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+        VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT);
 
     // Render spot lights shadow map atlas  ------------------------------------------
     //
@@ -590,8 +756,8 @@ void SampleRenderer::OnRender(int displayWidth, int displayHeight, State *pState
             rp_begin.framebuffer = m_pFrameBuffer_shadow;
             rp_begin.renderArea.offset.x = 0;
             rp_begin.renderArea.offset.y = 0;
-            rp_begin.renderArea.extent.width = m_shadowMap.GetWidth();
-            rp_begin.renderArea.extent.height = m_shadowMap.GetHeight();
+            rp_begin.renderArea.extent.width = shadowMapSize;
+            rp_begin.renderArea.extent.height = shadowMapSize;
             rp_begin.clearValueCount = 1;
             rp_begin.pClearValues = depth_clear_values;
 
@@ -608,8 +774,8 @@ void SampleRenderer::OnRender(int displayWidth, int displayHeight, State *pState
             // Set the RT's quadrant where to render the shadomap (these viewport offsets need to match the ones in shadowFiltering.h)
             uint32_t viewportOffsetsX[4] = { 0, 1, 0, 1 };
             uint32_t viewportOffsetsY[4] = { 0, 0, 1, 1 };
-            uint32_t viewportWidth = m_shadowMap.GetWidth() / 2;
-            uint32_t viewportHeight = m_shadowMap.GetHeight() / 2;
+            uint32_t viewportWidth = shadowMapSize / 2;
+            uint32_t viewportHeight = shadowMapSize / 2;
             SetViewportAndScissor(cmdBuf1, viewportOffsetsX[shadowMapIndex] * viewportWidth, viewportOffsetsY[shadowMapIndex] * viewportHeight, viewportWidth, viewportHeight);
 
             //set per frame constant buffer values
@@ -630,23 +796,12 @@ void SampleRenderer::OnRender(int displayWidth, int displayHeight, State *pState
     //
     SetPerfMarkerBegin(cmdBuf1, "Color pass");
 
-    VkRect2D renderArea = { 0, 0, pState->renderWidth, pState->renderHeight };
-
-    if (pPerFrame != NULL && m_gltfPBR)
+    if (cmdOpaque != VK_NULL_HANDLE)
     {
-        std::vector<GltfPbrPass::BatchList> opaque, transparent;
-        m_gltfPBR->BuildBatchLists(&opaque, &transparent);
-
-        // Render opaque 
+        // Render opaque, recorded by a worker
         //
-        {
-            m_renderPassFullGBufferWithClear.BeginPass(cmdBuf1, renderArea);
-
-            m_gltfPBR->DrawBatchList(cmdBuf1, &opaque);
-            m_GPUTimer.GetTimeStamp(cmdBuf1, "PBR Opaque");
-
-            m_renderPassFullGBufferWithClear.EndPass(cmdBuf1);
-        }
+        continueAfter(cmdOpaque);
+        m_GPUTimer.GetTimeStamp(cmdBuf1, "PBR Opaque");
 
         // Render skydome
         //
@@ -678,18 +833,10 @@ void SampleRenderer::OnRender(int displayWidth, int displayHeight, State *pState
             m_renderPassJustDepthAndHdr.EndPass(cmdBuf1);
         }
 
-        // draw transparent geometry
+        // draw transparent geometry, recorded by a worker
         //
-        {
-            m_renderPassFullGBuffer.BeginPass(cmdBuf1, renderArea);
-
-            std::sort(transparent.begin(), transparent.end());
-            m_gltfPBR->DrawBatchList(cmdBuf1, &transparent);
-            m_GPUTimer.GetTimeStamp(cmdBuf1, "PBR Transparent");
-
-            //m_GBuffer.EndPass(cmdBuf1);
-            m_renderPassFullGBuffer.EndPass(cmdBuf1);
-        }
+        continueAfter(cmdTransparent);
+        m_GPUTimer.GetTimeStamp(cmdBuf1, "PBR Transparent");
 
         // draw object's bounding boxes
         //
@@ -738,6 +885,27 @@ void SampleRenderer::OnRender(int displayWidth, int displayHeight, State *pState
         m_renderPassJustDepthAndHdr.EndPass(cmdBuf1);
     }
 
+    // With a viewport smaller than the targets the rest of the HDR target holds whatever earlier frames left there, and downsample
+    // and bloom filter the whole texture. Clear it to black so nothing stale bleeds back into the edge of the image.
+    if (pState->renderWidth < pState->renderTargetWidth || pState->renderHeight < pState->renderTargetHeight)
+    {
+        VkRect2D targetArea = { 0, 0, pState->renderTargetWidth, pState->renderTargetHeight };
+        VkClearAttachment clear = {};
+        clear.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        clear.colorAttachment = 0;
+        VkClearRect rects[2] = {};
+        rects[0].rect = { { (int32_t)pState->renderWidth, 0 }, { pState->renderTargetWidth - pState->renderWidth, pState->renderTargetHeight } };
+        rects[0].layerCount = 1;
+        rects[1].rect = { { 0, (int32_t)pState->renderHeight }, { pState->renderWidth, pState->renderTargetHeight - pState->renderHeight } };
+        rects[1].layerCount = 1;
+        uint32_t first = (pState->renderWidth < pState->renderTargetWidth) ? 0 : 1;
+        uint32_t count = (pState->renderHeight < pState->renderTargetHeight) ? 2 - first : 1;
+        m_renderPassJustDepthAndHdr.BeginPass(cmdBuf1, targetArea);
+        vkCmdClearAttachments(cmdBuf1, 1, &clear, count, rects + first);
+        m_renderPassJustDepthAndHdr.EndPass(cmdBuf1);
+        m_GPUTimer.GetTimeStamp(cmdBuf1, "Clear outside viewport");
+    }
+
     VkImageMemoryBarrier barrier[1] = {};
     barrier[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
     barrier[0].pNext = NULL;
@@ -778,7 +946,7 @@ void SampleRenderer::OnRender(int displayWidth, int displayHeight, State *pState
 
     // Apply TAA & Sharpen to m_HDR
     //
-    if (pState->bUseTAA)
+    if (taa)
     {
         {
             VkImageMemoryBarrier barrier = {};
@@ -834,10 +1002,17 @@ void SampleRenderer::OnRender(int displayWidth, int displayHeight, State *pState
     vpr.height = -(float)(pState->renderHeight);
     vpr.maxDepth = (float)1.0f;
 
-    // submit command buffer
+    // submit command buffers
     {
         VkResult res = vkEndCommandBuffer(cmdBuf1);
         assert(res == VK_SUCCESS);
+        cmdBufs.push_back(cmdBuf1);
+        if (opaqueRecorded.valid())
+        {
+            opaqueRecorded.wait();
+            transparentRecorded.wait();
+        }
+        m_GPUTimer.GetTimeStampUser({ "CPU scene record", (float)((MillisecondsNow() - recordStart) * 1000.0) });
 
         VkSubmitInfo submit_info;
         submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
@@ -845,8 +1020,8 @@ void SampleRenderer::OnRender(int displayWidth, int displayHeight, State *pState
         submit_info.waitSemaphoreCount = 0;
         submit_info.pWaitSemaphores = NULL;
         submit_info.pWaitDstStageMask = NULL;
-        submit_info.commandBufferCount = 1;
-        submit_info.pCommandBuffers = &cmdBuf1;
+        submit_info.commandBufferCount = (uint32_t)cmdBufs.size();
+        submit_info.pCommandBuffers = cmdBufs.data();
         submit_info.signalSemaphoreCount = 0;
         submit_info.pSignalSemaphores = NULL;
         res = vkQueueSubmit(m_pDevice->GetGraphicsQueue(), 1, &submit_info, VK_NULL_HANDLE);
@@ -854,22 +1029,61 @@ void SampleRenderer::OnRender(int displayWidth, int displayHeight, State *pState
     }
 
     // Wait for swapchain (we are going to render to it) -----------------------------------
+    // With the hidden window nothing is acquired, waiting for the frame that last used this slot is what keeps the rings safe.
     //
-    int imageIndex = pSwapChain->WaitForSwapChain();
+    int imageIndex = 0;
+    if (pState->bHiddenWindow)
+    {
+        VkResult res = vkWaitForFences(m_pDevice->GetDevice(), 1, &m_hiddenWindowFences[m_hiddenWindowFrame], VK_TRUE, UINT64_MAX);
+        assert(res == VK_SUCCESS);
+        res = vkResetFences(m_pDevice->GetDevice(), 1, &m_hiddenWindowFences[m_hiddenWindowFrame]);
+        assert(res == VK_SUCCESS);
+    }
+    else
+        imageIndex = pSwapChain->WaitForSwapChain();
 
     m_CommandListRing.OnBeginFrame();
 
     VkCommandBuffer cmdBuf2 = m_CommandListRing.GetNewCommandList();
-
-    {
-        VkCommandBufferBeginInfo cmd_buf_info;
-        cmd_buf_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-        cmd_buf_info.pNext = NULL;
-        cmd_buf_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-        cmd_buf_info.pInheritanceInfo = NULL;
-        VkResult res = vkBeginCommandBuffer(cmdBuf2, &cmd_buf_info);
-        assert(res == VK_SUCCESS);
-    }
+    BeginCommandBuffer(cmdBuf2);
+
+	// With async compute the upscale goes to the compute queue and the UI is recorded in a new command buffer that waits for it.
+	// Targets allocated for the graphics queue may alias, the upscale stays there until they are recreated.
+	bool async = !renderNative && pState->bUseAsyncCompute && m_asyncCompute.IsSupported() && !m_transientAllocator.IsAliasing();
+
+	// Recorded here rather than at the top of cmdBuf1: a full barrier there would make the next frame's scene wait for this frame's UI,
+	// and with async compute for the upscale it waits on.
+	// The back buffer can only be touched by a submission that waits on the image available semaphore. With async compute the part of
+	// cmdBuf2 up to the tonemapping is submitted without that wait (FSR_AsyncCompute::SubmitGraphics()), so there its barrier moves
+	// to the command buffer that follows AcquireOnGraphics().
+	// The render output is left out: it may share memory with the shadow map and its render pass starts from UNDEFINED anyway.
+	VkImageMemoryBarrier frameBarriers[2] = {};
+	frameBarriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	frameBarriers[0].srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+	frameBarriers[0].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+	frameBarriers[0].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	frameBarriers[0].newLayout = VK_IMAGE_LAYOUT_GENERAL;
+	frameBarriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	frameBarriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	frameBarriers[0].subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	frameBarriers[0].subresourceRange.baseMipLevel = 0;
+	frameBarriers[0].subresourceRange.levelCount = 1;
+	frameBarriers[0].subresourceRange.baseArrayLayer = 0;
+	frameBarriers[0].subresourceRange.layerCount = 1;
+	frameBarriers[0].image = m_displayOutput.Resource();
+	frameBarriers[1] = frameBarriers[0];
+	frameBarriers[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	frameBarriers[1].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	frameBarriers[1].image = pSwapChain->GetCurrentBackBuffer();
+	bool backBufferBarrier = !pState->bHiddenWindow;
+	vkCmdPipelineBarrier(cmdBuf2, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, NULL, 0, NULL, (backBufferBarrier && !async) ? 2 : 1, frameBarriers);
+	// And the other way around: the lighting sampled the shadow map after the shadow pass wrote it, the render output and the
+	// FSR intermediary are written next in the same bytes.
+	m_transientAllocator.AliasingBarrier(cmdBuf2,
+		VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+		VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT);
 
     SetPerfMarkerBegin(cmdBuf2, "Swapchain RenderPass");
     // prepare render pass
@@ -907,11 +1121,30 @@ void SampleRenderer::OnRender(int displayWidth, int displayHeight, State *pState
         m_toneMappingPS.Draw(cmdBuf2, m_GBuffer.m_HDRSRV, m_blueNoiseSRV, pState->m_nUpscaleType == 1 ? hdr : false, pState);
         m_GPUTimer.GetTimeStamp(cmdBuf2, "Tonemapping");
     }
-    if (!renderNative)
+    if (async)
     {
         vkCmdEndRenderPass(cmdBuf2);
-        m_FSR.Upscale(cmdBuf2, displayWidth, displayHeight, pState, &m_ConstantBufferRing, hdr);
-        m_GPUTimer.GetTimeStamp(cmdBuf2, pState->m_nUpscaleType == 1 ? "FSR 1.0" : "Upscaling");
+        SetPerfMarkerEnd(cmdBuf2);
+        m_asyncCompute.SubmitGraphics(cmdBuf2, m_renderOutput, m_displayOutput.Resource());
+
+        VkCommandBuffer cmdBufCompute = m_asyncCompute.BeginUpscale(m_renderOutput, m_displayOutput.Resource());
+        m_FSR.Upscale(cmdBufCompute, displayWidth, displayHeight, pState, hdr, NULL, true);
+        m_asyncCompute.SubmitUpscale(cmdBufCompute, m_renderOutput, m_displayOutput.Resource());
+
+        cmdBuf2 = m_CommandListRing.GetNewCommandList();
+        VkCommandBufferBeginInfo cmd_buf_info = {};
+        cmd_buf_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        cmd_buf_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        VkResult res = vkBeginCommandBuffer(cmdBuf2, &cmd_buf_info);
+        assert(res == VK_SUCCESS);
+        SetPerfMarkerBegin(cmdBuf2, "Swapchain RenderPass");
+        m_asyncCompute.AcquireOnGraphics(cmdBuf2, m_renderOutput, m_displayOutput.Resource());
+        if (backBufferBarrier)
+            vkCmdPipelineBarrier(cmdBuf2, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, NULL, 0, NULL, 1, &frameBarriers[1]);
+    } else if (!renderNative)
+    {
+        vkCmdEndRenderPass(cmdBuf2);
+        m_FSR.Upscale(cmdBuf2, displayWidth, displayHeight, pState, hdr, &m_GPUTimer);
     }
     vkCmdSetScissor(cmdBuf2, 0, 1, &rsd);
     vkCmdSetViewport(cmdBuf2, 0, 1, &vpd);
@@ -1002,7 +1235,11 @@ void SampleRenderer::OnRender(int displayWidth, int displayHeight, State *pState
         barrier[0].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
         vkCmdPipelineBarrier(cmdBuf2, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, barrier, 0, NULL, 0, NULL);
     }
-    if (hdr)
+    if (pState->bHiddenWindow)
+    {
+        // Nothing to present, the frame ends in m_displayOutput (or the magnifier output).
+    }
+    else if (hdr)
     {
         vkCmdSetScissor(cmdBuf2, 0, 1, &rsd);
         vkCmdSetViewport(cmdBuf2, 0, 1, &vpd);
@@ -1058,21 +1295,31 @@ void SampleRenderer::OnRender(int displayWidth, int displayHeight, State *pState
         VkResult res = vkEndCommandBuffer(cmdBuf2);
         assert(res == VK_SUCCESS);
 
-        VkSemaphore ImageAvailableSemaphore;
-        VkSemaphore RenderFinishedSemaphores;
+        VkSemaphore ImageAvailableSemaphore = VK_NULL_HANDLE;
+        VkSemaphore RenderFinishedSemaphores = VK_NULL_HANDLE;
         VkFence CmdBufExecutedFences;
-        pSwapChain->GetSemaphores(&ImageAvailableSemaphore, &RenderFinishedSemaphores, &CmdBufExecutedFences);
-
-        VkPipelineStageFlags submitWaitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        if (pState->bHiddenWindow)
+        {
+            CmdBufExecutedFences = m_hiddenWindowFences[m_hiddenWindowFrame];
+            m_hiddenWindowFrame = (m_hiddenWindowFrame + 1) % backBufferCount;
+        }
+        else
+            pSwapChain->GetSemaphores(&ImageAvailableSemaphore, &RenderFinishedSemaphores, &CmdBufExecutedFences);
+
+        // The acquire barriers at the top of the command buffer must not start before the upscale is done, earlier stages may.
+        // With the hidden window there is no image to wait for and nothing to signal to a present.
+        VkSemaphore waitSemaphores[2] = { ImageAvailableSemaphore, m_asyncCompute.GetUpscaleDoneSemaphore() };
+        VkPipelineStageFlags submitWaitStages[2] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, FSR_AsyncCompute::GetUpscaleDoneWaitStages() };
+        uint32_t firstWait = pState->bHiddenWindow ? 1 : 0;
         VkSubmitInfo submit_info2;
         submit_info2.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
         submit_info2.pNext = NULL;
-        submit_info2.waitSemaphoreCount = 1;
-        submit_info2.pWaitSemaphores = &ImageAvailableSemaphore;
-        submit_info2.pWaitDstStageMask = &submitWaitStage;
+        submit_info2.waitSemaphoreCount = (async ? 2 : 1) - firstWait;
+        submit_info2.pWaitSemaphores = waitSemaphores + firstWait;
+        submit_info2.pWaitDstStageMask = submitWaitStages + firstWait;
         submit_info2.commandBufferCount = 1;
         submit_info2.pCommandBuffers = &cmdBuf2;
-        submit_info2.signalSemaphoreCount = 1;
+        submit_info2.signalSemaphoreCount = pState->bHiddenWindow ? 0 : 1;
         submit_info2.pSignalSemaphores = &RenderFinishedSemaphores;
 
         res = vkQueueSubmit(m_pDevice->GetGraphicsQueue(), 1, &submit_info2, CmdBufExecutedFences);
@@ -20,9 +20,13 @@
 #include "base/GBuffer.h"
 #include "PostProc/MagnifierPS.h"
 #include "FSR_Filter.h"
+#include "FSR_AsyncCompute.h"
+#include "TransientAllocator.h"
 
 // We are queuing (backBufferCount + 0.5) frames, so we need to triple buffer the resources that get modified each frame
 static const int backBufferCount = 3;
+// 2Kx2K shadow map atlas, 4 cascades/spotlights of 1Kx1K
+static const uint32_t shadowMapSize = 2 * 1024;
 
 using namespace CAULDRON_VK;
 
@@ -45,8 +49,23 @@ struct State
 	bool  bUseTAA;
     bool  bUseRcas = true;
     float rcasAttenuation = 0.25f;
+    bool  bUseFusedRcas = false;
+    bool  bUseRcasHx2 = false;
+    bool  bUseEasuHx2 = false; // packed FsrEasuHx2, opt-in until it has been checked against FsrEasuH
+    bool  bUseTepd = false;
+    bool  bUseLfga = false;
+    float lfgaAmount = 0.25f;
+    bool  bCompareFused = false; // one-shot comparison of the fused pass or the packed EASU against FsrEasuH
+    bool  bSplitScreen = false; // FSR, bilinear and optionally EASU alone side by side in the same frame
+    bool  bSplitScreenEasu = false;
+    bool  bUseAsyncCompute = false;
+    bool  bUseFp16 = true; // FSR with packed fp16 math when the device has it, the slow fallback otherwise
+    bool  bParallelRecording = true; // the PBR batch lists are recorded on workers
 
 	bool  bIsBenchmarking;
+	// Runs the benchmark in a window that is never shown, the frames end in the display output and nothing is presented (Vulkan only).
+	// It still needs a desktop session and a GPU, the swapchain is created as usual.
+	bool  bHiddenWindow = false;
 	bool  bIsValidationLayerEnabled;
 	bool  bVSyncIsOn;
 
@@ -62,6 +81,12 @@ struct State
 
 	uint32_t renderWidth = 0;
 	uint32_t renderHeight = 0;
+	// Size the render targets are allocated with. Same as renderWidth/Height unless dynamic resolution is on,
+	// then they stay at display size and renderWidth/Height is the viewport rendered into them every frame.
+	uint32_t renderTargetWidth = 0;
+	uint32_t renderTargetHeight = 0;
+	bool  bDynamicResolution = false;
+	float targetFrameTime = 16.6f; // ms
 
     int m_nUpscaleType = 1;
     float mipBias = 0.0f;
@@ -83,7 +108,8 @@ public:
         float intensity;
     };
 
-    void OnCreate(Device *pDevice, SwapChain *pSwapChain, float fontSize, bool glsl);
+    // parallelCreate builds the passes on the async pool, off it's the serial reference for startup timings.
+    void OnCreate(Device *pDevice, SwapChain *pSwapChain, float fontSize, bool glsl, bool parallelCreate = true);
     void OnDestroy();
 
     void OnCreateWindowSizeDependentResources(SwapChain *pSwapChain, int displayWidth, int displayHeight, State *pState);
@@ -95,10 +121,25 @@ public:
     void UnloadScene();
 
     const std::vector<TimeStamp> &GetTimingValues() { return m_TimeStamps; }
+    const FSR_Filter::FusedComparison &GetFusedComparison() { return m_FSR.GetFusedComparison(); }
+    const std::vector<FSR_Filter::PassStatistics> &GetPassStatistics() const { return m_FSR.GetPassStatistics(); }
+    bool IsAsyncComputeSupported() const { return m_asyncCompute.IsSupported(); }
+    bool IsEasuHx2Available() const { return m_FSR.IsEasuHx2Available(); }
+    const FSR_AsyncCompute::Stats &GetAsyncComputeStats() const { return m_asyncCompute.GetStats(); }
+    const TransientAllocator &GetTransientAllocator() const { return m_transientAllocator; }
+    float GetCreateTime() const { return m_createTime; } // milliseconds the last OnCreate() took
 
     void OnRender(int displayWidth, int displayHeight, State *pState, SwapChain *pSwapChain);
 
 private:
+    enum ParallelPass
+    {
+        PARALLEL_OPAQUE,
+        PARALLEL_TRANSPARENT,
+        PARALLEL_PASS_COUNT
+    };
+    VkCommandBuffer BeginParallelCommandBuffer(uint32_t slot, ParallelPass pass);
+
     Device *m_pDevice;
 
     // Initialize helper classes
@@ -126,6 +167,7 @@ private:
     ColorConversionPS               m_colorConversionPS;
     TAA                             m_TAA;
 	FSR_Filter						m_FSR;
+	FSR_AsyncCompute				m_asyncCompute;
     MagnifierPS                     m_magnifierPS;
     VkRenderPass                    m_magnifierRenderPass;
     VkFramebuffer                   m_magnifierFramebuffer;
@@ -139,12 +181,17 @@ private:
     GBufferRenderPass               m_renderPassJustDepthAndHdr;
     GBufferRenderPass               m_renderPassFullGBuffer;
 
+    // The shadow map, render output and FSR intermediary are placed by m_transientAllocator.
+    // The display output stays a Texture since the magnifier takes one.
+    TransientAllocator              m_transientAllocator;
+
     // shadowmaps
-    Texture                         m_shadowMap;
+    VkImage                         m_shadowMap;
     VkImageView                     m_shadowMapDSV;
     VkImageView                     m_shadowMapSRV;
 
-	Texture							m_renderOutput;
+    VkImage                         m_renderOutput;
+    VkImageView                     m_renderOutputRTV;
     VkRenderPass                    m_renderOutputRenderPass;
     VkFramebuffer                   m_renderOutputFramebuffer;
 	Texture							m_displayOutput;
@@ -164,6 +211,18 @@ private:
 
     std::vector<TimeStamp>          m_TimeStamps;
 
+    // Stand in for the swapchain fences when the window is hidden, one per frame in flight.
+    std::vector<VkFence>            m_hiddenWindowFences;
+    uint32_t                        m_hiddenWindowFrame = 0;
+
+    // What the workers record into, a pool each since a pool can't be used by two threads at once.
+    // A frame is submitted before it waits for the frame that last used its swapchain image, so a slot is only free again backBufferCount + 1 frames later.
+    static const uint32_t           s_parallelSlots = backBufferCount + 1;
+    VkCommandPool                   m_parallelPools[s_parallelSlots][PARALLEL_PASS_COUNT] = {};
+    VkCommandBuffer                 m_parallelCmdBufs[s_parallelSlots][PARALLEL_PASS_COUNT] = {};
+    uint32_t                        m_parallelFrame = 0;
+
     AsyncPool                       m_asyncPool;
+    float                           m_createTime = 0.0f;
 };
 
@@ -0,0 +1,118 @@
+// FidelityFX Super Resolution Sample
+//
+// Copyright (c) 2021 Advanced Micro Devices, Inc. All rights reserved.
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "stdafx.h"
+#include "TimingHistory.h"
+#include <algorithm>
+#include <cmath>
+
+void TimingHistory::OnFrame(const std::vector<TimeStamp>& timeStamps, float cpuFrameTime)
+{
+	for (const TimeStamp& timeStamp : timeStamps)
+	{
+		Series& series = m_series[timeStamp.m_label];
+		if (series.values.size() < s_historyFrames)
+			series.values.push_back(timeStamp.m_microseconds);
+		else
+		{
+			series.values[series.next] = timeStamp.m_microseconds;
+			series.next = (series.next + 1) % s_historyFrames;
+		}
+	}
+
+	if (m_tracing)
+	{
+		Frame frame;
+		frame.start = MillisecondsNow() - m_traceStart;
+		frame.cpuTime = cpuFrameTime;
+		frame.timeStamps = timeStamps;
+		m_trace.push_back(frame);
+	}
+}
+
+void TimingHistory::Reset()
+{
+	m_series.clear();
+}
+
+float TimingHistory::Percentile(const std::vector<float>& sorted, float p)
+{
+	size_t rank = (size_t)std::ceil(p * sorted.size());
+	return sorted[std::min<size_t>(sorted.size() - 1, (rank > 0) ? rank - 1 : 0)];
+}
+
+bool TimingHistory::GetPercentiles(const std::string& label, float* pP50, float* pP95, float* pP99) const
+{
+	std::map<std::string, Series>::const_iterator it = m_series.find(label);
+	if (it == m_series.end() || it->second.values.empty())
+		return false;
+
+	std::vector<float> sorted = it->second.values;
+	std::sort(sorted.begin(), sorted.end());
+	*pP50 = Percentile(sorted, 0.50f);
+	*pP95 = Percentile(sorted, 0.95f);
+	*pP99 = Percentile(sorted, 0.99f);
+	return true;
+}
+
+void TimingHistory::StartTrace()
+{
+	m_trace.clear();
+	m_traceStart = MillisecondsNow();
+	m_tracing = true;
+}
+
+bool TimingHistory::StopTrace(const std::string& filename)
+{
+	m_tracing = false;
+	std::ofstream file(filename);
+	if (!file)
+	{
+		Trace(format("Can't write the trace to %s\n", filename.c_str()));
+		return false;
+	}
+
+	// Timestamps of trace events are in microseconds.
+	json events = json::array();
+	events.push_back({ { "name", "thread_name" }, { "ph", "M" }, { "pid", 1 }, { "tid", 1 }, { "args", { { "name", "CPU" } } } });
+	events.push_back({ { "name", "thread_name" }, { "ph", "M" }, { "pid", 1 }, { "tid", 2 }, { "args", { { "name", "GPU" } } } });
+	for (const Frame& frame : m_trace)
+	{
+		double ts = frame.start * 1000.0;
+		events.push_back({ { "name", "CPU frame" }, { "ph", "X" }, { "pid", 1 }, { "tid", 1 }, { "ts", ts }, { "dur", frame.cpuTime * 1000.0f } });
+		// The last timestamp is the whole GPU frame.
+		for (size_t i = 0; i < frame.timeStamps.size(); i++)
+		{
+			const TimeStamp& timeStamp = frame.timeStamps[i];
+			if (i + 1 == frame.timeStamps.size())
+				events.push_back({ { "name", "GPU frame" }, { "ph", "X" }, { "pid", 1 }, { "tid", 2 }, { "ts", ts }, { "dur", timeStamp.m_microseconds } });
+			else
+				events.push_back({ { "name", timeStamp.m_label }, { "ph", "C" }, { "pid", 1 }, { "ts", ts }, { "args", { { "us", timeStamp.m_microseconds } } } });
+		}
+	}
+
+	json trace;
+	trace["traceEvents"] = events;
+	trace["displayTimeUnit"] = "ms";
+	file << trace.dump();
+	Trace(format("Trace of %d frames written to %s\n", (int)m_trace.size(), filename.c_str()));
+	m_trace.clear();
+	return true;
+}
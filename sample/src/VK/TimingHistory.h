@@ -0,0 +1,66 @@
+// FidelityFX Super Resolution Sample
+//
+// Copyright (c) 2021 Advanced Micro Devices, Inc. All rights reserved.
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+// Keeps the last s_historyFrames values of every timestamp for rolling percentiles, and optionally every frame
+// since StartTrace() for a Chrome trace event file (chrome://tracing, Perfetto).
+// In the trace each frame is an event on a CPU track lasting the CPU frame time, and an event on a GPU track lasting
+// the total GPU time. The GPU timings are a few frames old when they are read back, they are put on the frame that
+// read them. Every other timestamp is a counter, which is what the viewers plot and compare across files best.
+class TimingHistory
+{
+public:
+	static const size_t s_historyFrames = 256;
+
+	// Once per frame with the timestamps the renderer read back and the CPU frame time in milliseconds.
+	void OnFrame(const std::vector<TimeStamp>& timeStamps, float cpuFrameTime);
+	// Drops the rolling values, e.g. after a settings change made them incomparable. The trace keeps going.
+	void Reset();
+
+	// Microseconds, false until the label was seen at least once since Reset().
+	bool GetPercentiles(const std::string& label, float* pP50, float* pP95, float* pP99) const;
+	// Nearest rank of sorted, non empty samples, p in [0, 1].
+	static float Percentile(const std::vector<float>& sorted, float p);
+
+	void StartTrace();
+	// Writes the frames since StartTrace() and stops recording.
+	bool StopTrace(const std::string& filename);
+	bool IsTracing() const { return m_tracing; }
+	size_t GetTraceFrameCount() const { return m_trace.size(); }
+
+private:
+	struct Series
+	{
+		std::vector<float>          values;
+		size_t                      next = 0; // oldest value once the window is full
+	};
+	struct Frame
+	{
+		double                      start = 0.0; // milliseconds since StartTrace()
+		float                       cpuTime = 0.0f;
+		std::vector<TimeStamp>      timeStamps;
+	};
+
+	std::map<std::string, Series>   m_series;
+	bool                            m_tracing = false;
+	double                          m_traceStart = 0.0;
+	std::vector<Frame>              m_trace;
+};
@@ -0,0 +1,261 @@
+// FidelityFX Super Resolution Sample
+//
+// Copyright (c) 2021 Advanced Micro Devices, Inc. All rights reserved.
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "stdafx.h"
+#include "TransientAllocator.h"
+#include "Base/ExtDebugUtils.h"
+#include <algorithm>
+
+void TransientAllocator::OnCreate(Device* pDevice)
+{
+	m_pDevice = pDevice;
+	vkGetPhysicalDeviceMemoryProperties(pDevice->GetPhysicalDevice(), &m_memoryProperties);
+}
+
+void TransientAllocator::OnDestroy()
+{
+	Release();
+	for (Block& block : m_blocks)
+	{
+		for (Placement& placement : block.placements)
+			vkDestroyImage(m_pDevice->GetDevice(), placement.image, NULL);
+		vkFreeMemory(m_pDevice->GetDevice(), block.memory, NULL);
+	}
+	m_blocks.clear();
+	UpdateSizes();
+}
+
+uint32_t TransientAllocator::FindMemoryType(uint32_t memoryTypeBits) const
+{
+	for (uint32_t i = 0; i < m_memoryProperties.memoryTypeCount; i++)
+		if ((memoryTypeBits & (1u << i)) && (m_memoryProperties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT))
+			return i;
+	assert(!"no device local memory type for the image");
+	return 0;
+}
+
+VkImage TransientAllocator::Create(const VkImageCreateInfo& info, Pass first, Pass last, const char* name, Placement* pPlacement)
+{
+	assert(first <= last);
+	VkImage image;
+	VkResult res = vkCreateImage(m_pDevice->GetDevice(), &info, NULL, &image);
+	assert(res == VK_SUCCESS);
+	SetResourceName(m_pDevice->GetDevice(), VK_OBJECT_TYPE_IMAGE, (uint64_t)image, name);
+
+	pPlacement->image = image;
+	vkGetImageMemoryRequirements(m_pDevice->GetDevice(), image, &pPlacement->requirements);
+	pPlacement->first = first;
+	pPlacement->last = last;
+	pPlacement->name = name;
+	return image;
+}
+
+VkImage TransientAllocator::CreatePersistentImage(const VkImageCreateInfo& info, Pass first, Pass last, const char* name)
+{
+	Block block;
+	Placement placement;
+	VkImage image = Create(info, first, last, name, &placement);
+	placement.persistent = true;
+	block.size = placement.requirements.size;
+	block.memoryType = FindMemoryType(placement.requirements.memoryTypeBits);
+	block.persistent = true;
+	block.placements.push_back(placement);
+	AllocateBlock(&block);
+	m_blocks.push_back(block);
+	UpdateSizes();
+	return image;
+}
+
+VkImage TransientAllocator::CreateImage(const VkImageCreateInfo& info, Pass first, Pass last, const char* name)
+{
+	Placement placement;
+	VkImage image = Create(info, first, last, name, &placement);
+	m_pending.push_back(placement);
+	return image;
+}
+
+VkDeviceSize TransientAllocator::FindOffset(const Block& block, const Placement& placement, VkDeviceSize limit)
+{
+	if ((placement.requirements.memoryTypeBits & (1u << block.memoryType)) == 0)
+		return UINT64_MAX;
+
+	// Candidates are the start of the block and the end of everything that is alive at the same time.
+	VkDeviceSize alignment = placement.requirements.alignment;
+	std::vector<VkDeviceSize> candidates(1, 0);
+	for (const Placement& other : block.placements)
+		if (other.first <= placement.last && placement.first <= other.last)
+			candidates.push_back((other.offset + other.requirements.size + alignment - 1) / alignment * alignment);
+	std::sort(candidates.begin(), candidates.end());
+
+	for (VkDeviceSize offset : candidates)
+	{
+		VkDeviceSize end = offset + placement.requirements.size;
+		if (end > limit)
+			break;
+		bool fits = true;
+		for (const Placement& other : block.placements)
+			if (other.first <= placement.last && placement.first <= other.last && offset < other.offset + other.requirements.size && other.offset < end)
+			{
+				fits = false;
+				break;
+			}
+		if (fits)
+			return offset;
+	}
+	return UINT64_MAX;
+}
+
+void TransientAllocator::AllocateBlock(Block* pBlock)
+{
+	VkMemoryAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = pBlock->size;
+	allocInfo.memoryTypeIndex = pBlock->memoryType;
+	VkResult res = vkAllocateMemory(m_pDevice->GetDevice(), &allocInfo, NULL, &pBlock->memory);
+	assert(res == VK_SUCCESS);
+	for (const Placement& placement : pBlock->placements)
+	{
+		if (placement.persistent != pBlock->persistent)
+			continue;
+		res = vkBindImageMemory(m_pDevice->GetDevice(), placement.image, pBlock->memory, placement.offset);
+		assert(res == VK_SUCCESS);
+	}
+}
+
+void TransientAllocator::Allocate(bool alias)
+{
+	// Biggest first, so the small ones fill the gaps.
+	std::sort(m_pending.begin(), m_pending.end(), [](const Placement& a, const Placement& b) { return a.requirements.size > b.requirements.size; });
+	m_aliasing = alias && !m_pending.empty();
+	if (!alias)
+	{
+		for (Placement& placement : m_pending)
+		{
+			placement.first = PASS_SHADOW;
+			placement.last = PASS_PRESENT;
+		}
+	}
+
+	std::vector<Block> heaps;
+	for (Placement& placement : m_pending)
+	{
+		bool placed = false;
+		for (Block& block : m_blocks)
+		{
+			if (!block.persistent)
+				continue;
+			VkDeviceSize offset = FindOffset(block, placement, block.size);
+			if (offset != UINT64_MAX)
+			{
+				placement.offset = offset;
+				block.placements.push_back(placement);
+				VkResult res = vkBindImageMemory(m_pDevice->GetDevice(), placement.image, block.memory, offset);
+				assert(res == VK_SUCCESS);
+				placed = true;
+				break;
+			}
+		}
+		// The leftovers go to a block per memory type that grows as needed.
+		for (size_t i = 0; i < heaps.size() && !placed; i++)
+		{
+			VkDeviceSize offset = FindOffset(heaps[i], placement, UINT64_MAX - placement.requirements.size);
+			if (offset != UINT64_MAX)
+			{
+				placement.offset = offset;
+				heaps[i].placements.push_back(placement);
+				heaps[i].size = std::max<VkDeviceSize>(heaps[i].size, offset + placement.requirements.size);
+				placed = true;
+			}
+		}
+		if (!placed)
+		{
+			Block heap;
+			heap.memoryType = FindMemoryType(placement.requirements.memoryTypeBits);
+			heap.size = placement.requirements.size;
+			placement.offset = 0;
+			heap.placements.push_back(placement);
+			heaps.push_back(heap);
+		}
+	}
+	for (Block& heap : heaps)
+	{
+		AllocateBlock(&heap);
+		m_blocks.push_back(heap);
+	}
+	m_pending.clear();
+
+	UpdateSizes();
+	Trace(format("Render targets: %.1f MB with dedicated allocations, %.1f MB %s\n", m_dedicatedSize / (1024.0 * 1024.0), m_allocatedSize / (1024.0 * 1024.0), alias ? "aliased" : "without aliasing"));
+}
+
+void TransientAllocator::AliasingBarrier(VkCommandBuffer cmd_buf, VkPipelineStageFlags srcStages, VkAccessFlags srcAccess, VkPipelineStageFlags dstStages, VkAccessFlags dstAccess) const
+{
+	if (!m_aliasing)
+		return;
+	// A global barrier: the next occupant starts from VK_IMAGE_LAYOUT_UNDEFINED, all that is needed is that the old writes are
+	// done and made available before the new ones land on the same bytes.
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = srcAccess;
+	barrier.dstAccessMask = dstAccess;
+	vkCmdPipelineBarrier(cmd_buf, srcStages, dstStages, 0, 1, &barrier, 0, NULL, 0, NULL);
+}
+
+void TransientAllocator::Release()
+{
+	for (Placement& placement : m_pending)
+		vkDestroyImage(m_pDevice->GetDevice(), placement.image, NULL);
+	m_pending.clear();
+	m_aliasing = false;
+
+	for (size_t i = 0; i < m_blocks.size();)
+	{
+		Block& block = m_blocks[i];
+		for (size_t j = 0; j < block.placements.size();)
+		{
+			if (block.placements[j].persistent)
+			{
+				j++;
+				continue;
+			}
+			vkDestroyImage(m_pDevice->GetDevice(), block.placements[j].image, NULL);
+			block.placements.erase(block.placements.begin() + j);
+		}
+		if (block.persistent)
+		{
+			i++;
+			continue;
+		}
+		vkFreeMemory(m_pDevice->GetDevice(), block.memory, NULL);
+		m_blocks.erase(m_blocks.begin() + i);
+	}
+	UpdateSizes();
+}
+
+void TransientAllocator::UpdateSizes()
+{
+	m_dedicatedSize = 0;
+	m_allocatedSize = 0;
+	for (const Block& block : m_blocks)
+	{
+		m_allocatedSize += block.size;
+		for (const Placement& placement : block.placements)
+			m_dedicatedSize += placement.requirements.size;
+	}
+}
@@ -0,0 +1,101 @@
+// FidelityFX Super Resolution Sample
+//
+// Copyright (c) 2021 Advanced Micro Devices, Inc. All rights reserved.
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+// Places render targets that are only alive for part of the frame in shared device memory.
+// Every image says in which passes it is first and last used, and two images only share bytes when those ranges don't meet.
+// Users must not rely on the contents surviving outside of that range, every first use has to start from VK_IMAGE_LAYOUT_UNDEFINED.
+//
+// Persistent images (created at startup) get a block of their own that the window size dependent images are placed into first,
+// whatever doesn't fit there goes to one more block that is released with them.
+// The allocator only places memory: at every hand-off the caller records AliasingBarrier() with the last-use stages and accesses of
+// the previous occupant, within a frame and across frames. Those barriers only order work on one queue, so when images are used
+// on another queue (the async compute upscale) Allocate(false) keeps every image in bytes of its own instead.
+class TransientAllocator
+{
+public:
+	// Frame order of the passes the sample owns images for.
+	enum Pass
+	{
+		PASS_SHADOW,
+		PASS_GBUFFER,
+		PASS_POST,
+		PASS_TONEMAP,
+		PASS_EASU,
+		PASS_RCAS,
+		PASS_PRESENT,
+		PASS_COUNT
+	};
+
+	void OnCreate(Device* pDevice);
+	void OnDestroy();
+
+	// Created and bound right away, lives until OnDestroy().
+	VkImage CreatePersistentImage(const VkImageCreateInfo& info, Pass first, Pass last, const char* name);
+	// Created right away, bound by the next Allocate() and destroyed by Release().
+	VkImage CreateImage(const VkImageCreateInfo& info, Pass first, Pass last, const char* name);
+	// With alias false the images are placed as if alive for the whole frame, they share memory with nothing.
+	void Allocate(bool alias);
+	void Release();
+
+	// True when the images of the last Allocate() may share memory with another one.
+	bool IsAliasing() const { return m_aliasing; }
+	// Orders the previous occupant's last use before the next occupant's first one, nothing is recorded when nothing is aliased.
+	void AliasingBarrier(VkCommandBuffer cmd_buf, VkPipelineStageFlags srcStages, VkAccessFlags srcAccess, VkPipelineStageFlags dstStages, VkAccessFlags dstAccess) const;
+
+	// Bytes the images would take with one allocation each, and what was actually allocated.
+	VkDeviceSize GetDedicatedSize() const { return m_dedicatedSize; }
+	VkDeviceSize GetAllocatedSize() const { return m_allocatedSize; }
+
+private:
+	struct Placement
+	{
+		VkImage                     image = VK_NULL_HANDLE;
+		VkMemoryRequirements        requirements = {};
+		Pass                        first = PASS_SHADOW;
+		Pass                        last = PASS_SHADOW;
+		VkDeviceSize                offset = 0;
+		bool                        persistent = false;
+		const char                  *name = NULL;
+	};
+	struct Block
+	{
+		VkDeviceMemory              memory = VK_NULL_HANDLE;
+		VkDeviceSize                size = 0;
+		uint32_t                    memoryType = 0;
+		bool                        persistent = false;
+		std::vector<Placement>      placements;
+	};
+
+	VkImage Create(const VkImageCreateInfo& info, Pass first, Pass last, const char* name, Placement* pPlacement);
+	uint32_t FindMemoryType(uint32_t memoryTypeBits) const;
+	// Lowest offset in the block where the image doesn't touch anything alive at the same time, UINT64_MAX if it doesn't fit.
+	static VkDeviceSize FindOffset(const Block& block, const Placement& placement, VkDeviceSize limit);
+	void AllocateBlock(Block* pBlock);
+	void UpdateSizes();
+
+	Device                          *m_pDevice = NULL;
+	VkPhysicalDeviceMemoryProperties m_memoryProperties = {};
+	std::vector<Block>              m_blocks;
+	std::vector<Placement>          m_pending;
+	VkDeviceSize                    m_dedicatedSize = 0;
+	VkDeviceSize                    m_allocatedSize = 0;
+	bool                            m_aliasing = false;
+};
@@ -0,0 +1,431 @@
+// FidelityFX Super Resolution Tools
+//
+// Copyright (c) 2021 Advanced Micro Devices, Inc. All rights reserved.
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// CPU emulation of the FSR_Pass compute dispatch, used to study texture access patterns without a GPU.
+//
+// The emulation is address exact, not color exact: it replays the texel coordinates that 'CurrFilter()' in FSR_Pass
+// fetches for each thread, in the order a 64 wide wave issues them, but does not compute filtered colors.
+//  - Workgroups are 64 threads covering 16x16 pixels, each thread calls 'CurrFilter()' four times (+8 x, +8 y, -8 x).
+//    Other thread block shapes (16x4, 32x2, ...) can be emulated, the workgroup then covers 2x2 of those blocks.
+//  - EASU issues 3 gathers (R, G and B) at each of its 4 gather positions, bilinear issues 1 filtered fetch and RCAS 5 loads.
+//  - The EASU and bilinear positions are computed from the real 'FsrEasuCon()' constants.
+//  - Gathers and bilinear fetches use 8 bits of sub-texel precision, like texture units do.
+
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+
+#define A_CPU
+#include "ffx_a.h"
+#include "ffx_fsr1.h"
+
+enum FsrEmuPass
+{
+    FSR_EMU_BILINEAR,
+    FSR_EMU_EASU,
+    FSR_EMU_RCAS,
+    FSR_EMU_PASS_COUNT
+};
+
+enum FsrEmuRemap
+{
+    FSR_EMU_REMAP_ARMP8X8,
+    FSR_EMU_REMAP_ARMPRED8X8,
+    FSR_EMU_REMAP_LINEAR,
+    FSR_EMU_REMAP_MORTON,
+    FSR_EMU_REMAP_COUNT
+};
+
+static const char *s_fsrEmuRemapNames[FSR_EMU_REMAP_COUNT] = { "ARmp8x8", "ARmpRed8x8", "linear", "morton" };
+
+// CPU ports of the ffx_a.h GPU bit field helpers and remaps.
+static inline AU1 FsrEmuBfe(AU1 src, AU1 off, AU1 bits) { return (src >> off) & ((1u << bits) - 1u); }
+static inline AU1 FsrEmuBfiM(AU1 src, AU1 ins, AU1 bits) { AU1 mask = (1u << bits) - 1u; return (ins & mask) | (src & (~mask)); }
+
+// The ARmp remaps only exist for 8x8 thread blocks.
+static inline bool FsrEmuRemapSupportsBlock(FsrEmuRemap remap, uint32_t blockWidth)
+{
+    return blockWidth == 8 || remap == FSR_EMU_REMAP_LINEAR || remap == FSR_EMU_REMAP_MORTON;
+}
+
+static inline void FsrEmuRemapThread(FsrEmuRemap remap, AU1 a, uint32_t blockWidth, AU1 &x, AU1 &y)
+{
+    switch (remap)
+    {
+        case FSR_EMU_REMAP_LINEAR:
+            x = a % blockWidth;
+            y = a / blockWidth;
+            break;
+        case FSR_EMU_REMAP_MORTON:
+        {
+            // Alternate bits between x and y until the shorter axis is full, remaining bits go to the longer axis.
+            AU1 maxX = blockWidth, maxY = 64 / blockWidth;
+            AU1 bitX = 1, bitY = 1;
+            bool toX = true;
+            x = y = 0;
+            for (AU1 bit = 1; bit < 64; bit <<= 1)
+            {
+                if ((toX && bitX < maxX) || bitY >= maxY)
+                {
+                    if (a & bit) x |= bitX;
+                    bitX <<= 1;
+                }
+                else
+                {
+                    if (a & bit) y |= bitY;
+                    bitY <<= 1;
+                }
+                toX = !toX;
+            }
+            break;
+        }
+        case FSR_EMU_REMAP_ARMPRED8X8:
+            x = FsrEmuBfiM(FsrEmuBfe(a, 2u, 3u), a, 1u);
+            y = FsrEmuBfiM(FsrEmuBfe(a, 3u, 3u), FsrEmuBfe(a, 1u, 2u), 2u);
+            break;
+        default:
+            x = FsrEmuBfe(a, 1u, 3u);
+            y = FsrEmuBfiM(FsrEmuBfe(a, 3u, 3u), a, 1u);
+            break;
+    }
+}
+
+//
+// Set associative LRU cache, addressed by texel position.
+// Cache lines hold a 2D block of texels (textures are tiled in memory, so lines are not single rows).
+//
+class FsrEmuTexCache
+{
+public:
+    void OnCreate(uint32_t sizeBytes, uint32_t ways, uint32_t lineBytes, uint32_t bytesPerTexel, uint32_t textureWidth)
+    {
+        m_ways = std::max(ways, 1u);
+        m_lineBytes = lineBytes;
+        m_sets = std::max(sizeBytes / (lineBytes * m_ways), 1u);
+
+        // Square-ish power of two block of texels per line, wider than tall.
+        uint32_t texels = std::max(lineBytes / bytesPerTexel, 1u);
+        m_lineTileW = 1;
+        m_lineTileH = 1;
+        while (m_lineTileW * m_lineTileH < texels)
+        {
+            if (m_lineTileW <= m_lineTileH) m_lineTileW *= 2;
+            else m_lineTileH *= 2;
+        }
+        m_linesPerRow = (textureWidth + m_lineTileW - 1) / m_lineTileW;
+
+        m_tags.assign(m_sets * m_ways, UINT64_MAX);
+        m_ages.assign(m_sets * m_ways, 0);
+        m_clock = 0;
+        m_hits = 0;
+        m_misses = 0;
+    }
+
+    uint64_t LineOf(int x, int y) const
+    {
+        return (uint64_t)(y / (int)m_lineTileH) * m_linesPerRow + (uint64_t)(x / (int)m_lineTileW);
+    }
+
+    // Returns true on hit.
+    bool Access(uint64_t line)
+    {
+        uint64_t *tags = &m_tags[(line % m_sets) * m_ways];
+        uint64_t *ages = &m_ages[(line % m_sets) * m_ways];
+        m_clock++;
+        uint32_t victim = 0;
+        for (uint32_t i = 0; i < m_ways; i++)
+        {
+            if (tags[i] == line)
+            {
+                ages[i] = m_clock;
+                m_hits++;
+                return true;
+            }
+            if (ages[i] < ages[victim])
+                victim = i;
+        }
+        tags[victim] = line;
+        ages[victim] = m_clock;
+        m_misses++;
+        return false;
+    }
+
+    uint64_t GetHits() const { return m_hits; }
+    uint64_t GetMisses() const { return m_misses; }
+    uint32_t GetLineBytes() const { return m_lineBytes; }
+
+private:
+    uint32_t m_sets = 1;
+    uint32_t m_ways = 1;
+    uint32_t m_lineBytes = 64;
+    uint32_t m_lineTileW = 1;
+    uint32_t m_lineTileH = 1;
+    uint64_t m_linesPerRow = 1;
+    std::vector<uint64_t> m_tags;
+    std::vector<uint64_t> m_ages;
+    uint64_t m_clock = 0;
+    uint64_t m_hits = 0;
+    uint64_t m_misses = 0;
+};
+
+struct FsrEmuTexel
+{
+    int x;
+    int y;
+};
+
+//
+// Generates the texel fetches of 'CurrFilter()' for one output pixel, grouped by instruction.
+//
+class FsrEmuCurrFilter
+{
+public:
+    static const uint32_t MAX_INSTRUCTIONS = 12;
+    static const uint32_t MAX_TEXELS_PER_INSTRUCTION = 4;
+
+    void OnCreate(FsrEmuPass pass, int inputWidth, int inputHeight, int outputWidth, int outputHeight)
+    {
+        m_pass = pass;
+        m_inputWidth = inputWidth;
+        m_inputHeight = inputHeight;
+        FsrEasuCon(m_con0, m_con1, m_con2, m_con3, (AF1)inputWidth, (AF1)inputHeight, (AF1)inputWidth, (AF1)inputHeight, (AF1)outputWidth, (AF1)outputHeight);
+    }
+
+    int GetInputWidth() const { return m_inputWidth; }
+    int GetInputHeight() const { return m_inputHeight; }
+
+    uint32_t GetInstructionCount() const
+    {
+        return m_pass == FSR_EMU_EASU ? 12 : (m_pass == FSR_EMU_RCAS ? 5 : 1);
+    }
+
+    // Texels fetched by instruction 'instr' for output pixel 'pos', returns the count.
+    uint32_t Fetch(uint32_t instr, AU1 posX, AU1 posY, FsrEmuTexel *pTexels) const
+    {
+        if (m_pass == FSR_EMU_RCAS)
+        {
+            static const int offsets[5][2] = { { 0, -1 }, { -1, 0 }, { 0, 0 }, { 1, 0 }, { 0, 1 } };
+            pTexels[0] = Clamp((int)posX + offsets[instr][0], (int)posY + offsets[instr][1]);
+            return 1;
+        }
+
+        AF1 ppX = (AF1)posX * AF1_AU1(m_con0[0]) + AF1_AU1(m_con0[2]);
+        AF1 ppY = (AF1)posY * AF1_AU1(m_con0[1]) + AF1_AU1(m_con0[3]);
+        if (m_pass == FSR_EMU_BILINEAR)
+        {
+            // Same as the 'SAMPLE_BILINEAR' path in FSR_Pass.
+            AF1 u = ppX * AF1_AU1(m_con1[0]) + AF1_(0.5) * AF1_AU1(m_con1[2]);
+            AF1 v = ppY * AF1_AU1(m_con1[1]) - AF1_(0.5) * AF1_AU1(m_con1[3]);
+            return Footprint(u, v, pTexels);
+        }
+
+        // Same as 'FsrEasuF()', three gathers (R, G, B) per position.
+        AF1 fpX = floorf(ppX);
+        AF1 fpY = floorf(ppY);
+        AF1 p0X = fpX * AF1_AU1(m_con1[0]) + AF1_AU1(m_con1[2]);
+        AF1 p0Y = fpY * AF1_AU1(m_con1[1]) + AF1_AU1(m_con1[3]);
+        AF1 u = p0X;
+        AF1 v = p0Y;
+        switch (instr / 3)
+        {
+            case 1: u += AF1_AU1(m_con2[0]); v += AF1_AU1(m_con2[1]); break;
+            case 2: u += AF1_AU1(m_con2[2]); v += AF1_AU1(m_con2[3]); break;
+            case 3: u += AF1_AU1(m_con3[0]); v += AF1_AU1(m_con3[1]); break;
+            default: break;
+        }
+        return Footprint(u, v, pTexels);
+    }
+
+private:
+    FsrEmuTexel Clamp(int x, int y) const
+    {
+        FsrEmuTexel t;
+        t.x = std::min(std::max(x, 0), m_inputWidth - 1);
+        t.y = std::min(std::max(y, 0), m_inputHeight - 1);
+        return t;
+    }
+
+    // 2x2 footprint of a gather or bilinear fetch at normalized 'u,v' with a clamping sampler.
+    uint32_t Footprint(AF1 u, AF1 v, FsrEmuTexel *pTexels) const
+    {
+        AF1 x = floorf((u * (AF1)m_inputWidth - 0.5f) * 256.0f + 0.5f) * (1.0f / 256.0f);
+        AF1 y = floorf((v * (AF1)m_inputHeight - 0.5f) * 256.0f + 0.5f) * (1.0f / 256.0f);
+        int x0 = (int)floorf(x);
+        int y0 = (int)floorf(y);
+        pTexels[0] = Clamp(x0, y0 + 1);
+        pTexels[1] = Clamp(x0 + 1, y0 + 1);
+        pTexels[2] = Clamp(x0 + 1, y0);
+        pTexels[3] = Clamp(x0, y0);
+        return 4;
+    }
+
+    FsrEmuPass m_pass = FSR_EMU_EASU;
+    int m_inputWidth = 0;
+    int m_inputHeight = 0;
+    AU1 m_con0[4] = {};
+    AU1 m_con1[4] = {};
+    AU1 m_con2[4] = {};
+    AU1 m_con3[4] = {};
+};
+
+struct FsrEmuStats
+{
+    uint64_t workgroups = 0;
+    uint64_t instructions = 0;      // per wave fetch instructions
+    uint64_t texelRequests = 0;     // per lane texels requested
+    uint64_t uniqueTexelsPerWg = 0; // summed over workgroups
+    uint64_t uniqueLinesPerWg = 0;  // summed over workgroups
+    uint64_t uniqueTexels = 0;      // over the whole dispatch
+    uint64_t lineRequests = 0;      // distinct lines per coalesced lane group, summed
+    uint64_t cacheHits = 0;
+    uint64_t cacheMisses = 0;
+    uint64_t l2Hits = 0;
+    uint64_t l2Misses = 0;
+    uint64_t outputPixels = 0;
+};
+
+struct FsrEmuDispatchDesc
+{
+    FsrEmuRemap remap = FSR_EMU_REMAP_ARMP8X8;
+    int outputWidth = 0;
+    int outputHeight = 0;
+    uint32_t blockWidth = 8;        // the 64 threads form a 'blockWidth' x '64 / blockWidth' block
+    uint32_t waveSize = 64;
+    uint32_t coalesceLanes = 64;    // lanes the texture unit coalesces per lookup (clamped to the wave size)
+    uint32_t lineBytes = 128;       // used for line counts, must match the caches when those are set
+    uint32_t bytesPerTexel = 4;
+    FsrEmuTexCache *pCache = NULL;  // optional texture cache
+    FsrEmuTexCache *pL2 = NULL;     // optional second level, looked up on texture cache misses
+};
+
+//
+// Runs a full dispatch in row major workgroup order, each workgroup covers 2x2 thread blocks (16x16 pixels for 8x8).
+// The 64 threads of a workgroup run as 64 / 'waveSize' waves, one after another.
+// Each fetch instruction is issued for all lanes of a wave before the next one. The texture unit processes an instruction
+// 'coalesceLanes' lanes at a time, each distinct cache line in such a group is looked up once.
+// The caches are shared across workgroups so inter-workgroup reuse is modelled too.
+//
+static FsrEmuStats FsrEmuDispatch(const FsrEmuCurrFilter &filter, const FsrEmuDispatchDesc &desc)
+{
+    FsrEmuStats stats;
+    const AU1 blockW = std::min(std::max(desc.blockWidth, 1u), 64u);
+    const AU1 blockH = 64 / blockW;
+    const uint32_t groupsX = (desc.outputWidth + blockW * 2 - 1) / (blockW * 2);
+    const uint32_t groupsY = (desc.outputHeight + blockH * 2 - 1) / (blockH * 2);
+    const uint32_t instructions = filter.GetInstructionCount();
+    const uint32_t waves = 64 / std::min(std::max(desc.waveSize, 1u), 64u);
+    const uint32_t lanes = 64 / waves;
+    const uint32_t coalesce = std::min(std::max(desc.coalesceLanes, 1u), lanes);
+    // Same walk as FSR_Pass: +x, +y, -x.
+    const AU1 callOffsets[4][2] = { { 0, 0 }, { blockW, 0 }, { blockW, blockH }, { 0, blockH } };
+    FsrEmuTexCache *pCache = desc.pCache;
+
+    // Stamps of the last workgroup that touched each texel and line, to count distinct ones without sorting.
+    const uint64_t inputTexels = (uint64_t)filter.GetInputWidth() * filter.GetInputHeight();
+    std::vector<uint32_t> texelStamps(inputTexels, 0);
+    std::vector<uint32_t> lineStamps;
+    std::vector<uint64_t> lineInstrStamps;
+    std::vector<uint64_t> instrLines;
+    uint32_t stamp = 0;
+    uint64_t instrStamp = 0;
+    FsrEmuTexel texels[FsrEmuCurrFilter::MAX_TEXELS_PER_INSTRUCTION];
+
+    // Same line footprint as the cache, used for line counts when the cache model is off.
+    FsrEmuTexCache lineMapper;
+    lineMapper.OnCreate(desc.lineBytes, 1, desc.lineBytes, desc.bytesPerTexel, (uint32_t)filter.GetInputWidth());
+    const FsrEmuTexCache &mapper = pCache ? *pCache : lineMapper;
+    const uint64_t lineCount = mapper.LineOf(filter.GetInputWidth() - 1, filter.GetInputHeight() - 1) + 1;
+    lineStamps.assign(lineCount, 0);
+    lineInstrStamps.assign(lineCount, 0);
+
+    for (uint32_t gy = 0; gy < groupsY; gy++)
+    {
+        for (uint32_t gx = 0; gx < groupsX; gx++)
+        {
+            stamp++;
+            for (uint32_t wave = 0; wave < waves; wave++)
+            {
+                for (uint32_t call = 0; call < 4; call++)
+                {
+                    for (uint32_t instr = 0; instr < instructions; instr++)
+                    {
+                        stats.instructions++;
+                        for (AU1 lane = wave * lanes; lane < (wave + 1) * lanes; lane++)
+                        {
+                            if ((lane % coalesce) == 0)
+                            {
+                                instrLines.clear();
+                                instrStamp++;
+                            }
+                            AU1 x, y;
+                            FsrEmuRemapThread(desc.remap, lane, blockW, x, y);
+                            x += gx * blockW * 2 + callOffsets[call][0];
+                            y += gy * blockH * 2 + callOffsets[call][1];
+                            // Out of bounds lanes still execute, only their stores are dropped.
+                            uint32_t count = filter.Fetch(instr, x, y, texels);
+                            stats.texelRequests += count;
+                            for (uint32_t t = 0; t < count; t++)
+                            {
+                                uint32_t &texelStamp = texelStamps[(uint64_t)texels[t].y * filter.GetInputWidth() + texels[t].x];
+                                if (texelStamp == 0)
+                                    stats.uniqueTexels++;
+                                if (texelStamp != stamp)
+                                    stats.uniqueTexelsPerWg++;
+                                texelStamp = stamp;
+                                uint64_t line = mapper.LineOf(texels[t].x, texels[t].y);
+                                if (lineInstrStamps[line] != instrStamp)
+                                    instrLines.push_back(line);
+                                lineInstrStamps[line] = instrStamp;
+                            }
+                            if (((lane + 1) % coalesce) != 0)
+                                continue;
+                            stats.lineRequests += instrLines.size();
+                            for (uint64_t line : instrLines)
+                            {
+                                if (lineStamps[line] != stamp)
+                                    stats.uniqueLinesPerWg++;
+                                lineStamps[line] = stamp;
+                                if (pCache && !pCache->Access(line) && desc.pL2)
+                                    desc.pL2->Access(line);
+                            }
+                        }
+                    }
+                }
+            }
+            stats.workgroups++;
+        }
+    }
+
+    stats.outputPixels = (uint64_t)desc.outputWidth * desc.outputHeight;
+    if (pCache)
+    {
+        stats.cacheHits = pCache->GetHits();
+        stats.cacheMisses = pCache->GetMisses();
+    }
+    if (desc.pL2)
+    {
+        stats.l2Hits = desc.pL2->GetHits();
+        stats.l2Misses = desc.pL2->GetMisses();
+    }
+    return stats;
+}
@@ -0,0 +1,189 @@
+// FidelityFX Super Resolution Tools
+//
+// Copyright (c) 2021 Advanced Micro Devices, Inc. All rights reserved.
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Texture cache traffic simulator for choosing the EASU dispatch layout per scale ratio.
+// Replays the gathers 'FsrEasuF()' issues for every combination of scale ratio, thread block shape and remap through a
+// two level set associative cache model, and reports hit rates, texture cache miss bytes and DRAM bytes per output pixel.
+// A row of workgroups only touches a few dozen input rows, so any L2 of a few hundred KB keeps the whole working set and the
+// DRAM bytes are close to the compulsory misses for every layout. The texture cache misses (L2 traffic) are what tells them apart.
+//
+// Usage: fsr_cache_sim [options]
+//   --output <w> <h>             Display resolution (default 3840 2160).
+//   --ratios <r> [r ...]         Scale ratios per dimension (default 1.3 1.5 1.7 2.0, the sample's presets).
+//   --blocks <w> [w ...]         Thread block widths, height is 64 / w (default 8 16 32).
+//   --cache <kb> <ways> <line>   Texture cache (default 16 16 128).
+//   --l2 <kb> <ways>             Second level cache, 0 disables it (default 4096 16).
+//   --wave <32|64>               Lanes per wave (default 64).
+//   --coalesce <lanes>           Lanes the texture unit coalesces per lookup (default 16).
+//   --bpp <bytes>                Bytes per input texel (default 4).
+//   --csv                        Comma separated output.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "FsrPassEmu.h"
+
+static bool IsNumber(const char *s)
+{
+    return s[0] != '-' || (s[1] >= '0' && s[1] <= '9');
+}
+
+int main(int argc, char **argv)
+{
+    int outputWidth = 3840, outputHeight = 2160;
+    std::vector<double> ratios;
+    std::vector<uint32_t> blocks;
+    uint32_t cacheKb = 16, cacheWays = 16, lineBytes = 128;
+    uint32_t l2Kb = 4096, l2Ways = 16;
+    uint32_t waveSize = 64, coalesce = 16, bpp = 4;
+    bool csv = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--output") == 0 && i + 2 < argc)
+        {
+            outputWidth = atoi(argv[++i]);
+            outputHeight = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--ratios") == 0)
+        {
+            while (i + 1 < argc && IsNumber(argv[i + 1]))
+                ratios.push_back(atof(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--blocks") == 0)
+        {
+            while (i + 1 < argc && IsNumber(argv[i + 1]))
+                blocks.push_back((uint32_t)atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--cache") == 0 && i + 3 < argc)
+        {
+            cacheKb = (uint32_t)atoi(argv[++i]);
+            cacheWays = (uint32_t)atoi(argv[++i]);
+            lineBytes = (uint32_t)atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--l2") == 0 && i + 2 < argc)
+        {
+            l2Kb = (uint32_t)atoi(argv[++i]);
+            l2Ways = (uint32_t)atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--wave") == 0 && i + 1 < argc)
+            waveSize = (uint32_t)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--coalesce") == 0 && i + 1 < argc)
+            coalesce = (uint32_t)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--bpp") == 0 && i + 1 < argc)
+            bpp = (uint32_t)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--csv") == 0)
+            csv = true;
+        else
+        {
+            printf("Usage: %s [--output w h] [--ratios r ...] [--blocks w ...] [--cache kb ways line] [--l2 kb ways] [--wave 32|64] [--coalesce lanes] [--bpp bytes] [--csv]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (ratios.empty())
+        ratios = { 1.3, 1.5, 1.7, 2.0 };
+    if (blocks.empty())
+        blocks = { 8, 16, 32 };
+    if (outputWidth <= 0 || outputHeight <= 0 || cacheKb == 0 || lineBytes == 0 || bpp == 0)
+    {
+        printf("Invalid arguments\n");
+        return 1;
+    }
+
+    if (csv)
+        printf("ratio,input_width,input_height,block,remap,lookups_per_pixel,cache_hit_rate,cache_miss_bytes_per_pixel,l2_hit_rate,dram_bytes_per_pixel\n");
+    else
+        printf("%dx%d output, %uKB %u-way cache, %uKB L2, %uB lines, wave%u, %u lanes per lookup\n",
+            outputWidth, outputHeight, cacheKb, cacheWays, l2Kb, lineBytes, waveSize, coalesce);
+
+    for (double ratio : ratios)
+    {
+        // Same rounding as the sample's render resolution.
+        int inputWidth = (int)(outputWidth / ratio);
+        int inputHeight = (int)(outputHeight / ratio);
+        if (inputWidth <= 0 || inputHeight <= 0)
+            continue;
+
+        FsrEmuCurrFilter filter;
+        filter.OnCreate(FSR_EMU_EASU, inputWidth, inputHeight, outputWidth, outputHeight);
+
+        if (!csv)
+        {
+            printf("\nratio %.2f (%dx%d)\n", ratio, inputWidth, inputHeight);
+            printf("  %-6s %-12s %12s %10s %12s %10s %12s\n", "block", "remap", "lookups/px", "hit rate", "miss B/px", "L2 hit", "DRAM B/px");
+        }
+
+        double bestBytes = 0.0;
+        char best[64] = "";
+        for (uint32_t blockWidth : blocks)
+        {
+            if (blockWidth == 0 || blockWidth > 64 || (64 % blockWidth) != 0)
+                continue;
+            for (int r = 0; r < FSR_EMU_REMAP_COUNT; r++)
+            {
+                if (!FsrEmuRemapSupportsBlock((FsrEmuRemap)r, blockWidth))
+                    continue;
+
+                FsrEmuTexCache cache, l2;
+                cache.OnCreate(cacheKb * 1024, cacheWays, lineBytes, bpp, (uint32_t)inputWidth);
+                if (l2Kb)
+                    l2.OnCreate(l2Kb * 1024, l2Ways, lineBytes, bpp, (uint32_t)inputWidth);
+
+                FsrEmuDispatchDesc desc;
+                desc.remap = (FsrEmuRemap)r;
+                desc.outputWidth = outputWidth;
+                desc.outputHeight = outputHeight;
+                desc.blockWidth = blockWidth;
+                desc.waveSize = waveSize;
+                desc.coalesceLanes = coalesce;
+                desc.lineBytes = lineBytes;
+                desc.bytesPerTexel = bpp;
+                desc.pCache = &cache;
+                desc.pL2 = l2Kb ? &l2 : NULL;
+                FsrEmuStats stats = FsrEmuDispatch(filter, desc);
+
+                double pixels = (double)stats.outputPixels;
+                double hitRate = (double)stats.cacheHits / (double)(stats.cacheHits + stats.cacheMisses);
+                double l2HitRate = l2Kb ? (double)stats.l2Hits / (double)std::max<uint64_t>(stats.l2Hits + stats.l2Misses, 1) : 0.0;
+                double missBytes = (double)stats.cacheMisses * lineBytes / pixels;
+                double dramBytes = (double)(l2Kb ? stats.l2Misses : stats.cacheMisses) * lineBytes / pixels;
+                double lookups = (double)stats.lineRequests / pixels;
+
+                char shape[16];
+                snprintf(shape, sizeof(shape), "%ux%u", blockWidth, 64 / blockWidth);
+                if (csv)
+                    printf("%.3f,%d,%d,%s,%s,%.4f,%.4f,%.4f,%.4f,%.4f\n", ratio, inputWidth, inputHeight, shape, s_fsrEmuRemapNames[r], lookups, hitRate, missBytes, l2HitRate, dramBytes);
+                else
+                    printf("  %-6s %-12s %12.3f %9.2f%% %12.3f %9.2f%% %12.3f\n", shape, s_fsrEmuRemapNames[r], lookups, 100.0 * hitRate, missBytes, 100.0 * l2HitRate, dramBytes);
+
+                // Least DRAM traffic wins, then least L2 traffic, then fewest lookups.
+                double score = dramBytes + missBytes * 1e-3 + lookups * 1e-6;
+                if (best[0] == 0 || score < bestBytes)
+                {
+                    bestBytes = score;
+                    snprintf(best, sizeof(best), "%s %s", shape, s_fsrEmuRemapNames[r]);
+                }
+            }
+        }
+        if (!csv && best[0])
+            printf("  best: %s\n", best);
+    }
+    return 0;
+}
@@ -0,0 +1,157 @@
+// FidelityFX Super Resolution Tools
+//
+// Copyright (c) 2021 Advanced Micro Devices, Inc. All rights reserved.
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Runs the FSR_Pass dispatch on the CPU for each 8x8 workgroup remap and reports input texel reuse and cache line traffic.
+//
+// Usage: fsr_pass_emu [options]
+//   --pass <easu|rcas|bilinear>   Pass to emulate (default easu).
+//   --input <w> <h>               Render resolution (default 1280 720), RCAS ignores this and uses the output size.
+//   --output <w> <h>              Display resolution (default 2560 1440).
+//   --cache <kb> <ways> <line>    Enable the texture cache model (for example 16 16 128).
+//   --bpp <bytes>                 Bytes per input texel (default 4).
+//   --line <bytes>                Cache line size used for line counts when the cache model is off (default 128).
+//   --wave <32|64>                Lanes per wave (default 64).
+//   --coalesce <lanes>            Lanes the texture unit coalesces per lookup (default 16). With a whole wave every remap
+//                                 touches the same lines per instruction, only smaller groups tell them apart.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "FsrPassEmu.h"
+
+static const char *s_fsrEmuPassNames[FSR_EMU_PASS_COUNT] = { "bilinear", "easu", "rcas" };
+
+int main(int argc, char **argv)
+{
+    FsrEmuPass pass = FSR_EMU_EASU;
+    int inputWidth = 1280, inputHeight = 720;
+    int outputWidth = 2560, outputHeight = 1440;
+    uint32_t cacheKb = 0, cacheWays = 16, lineBytes = 128, bpp = 4, waveSize = 64, coalesce = 16;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--pass") == 0 && i + 1 < argc)
+        {
+            ++i;
+            int p = 0;
+            while (p < FSR_EMU_PASS_COUNT && strcmp(argv[i], s_fsrEmuPassNames[p]) != 0)
+                p++;
+            if (p == FSR_EMU_PASS_COUNT)
+            {
+                printf("Unknown pass %s\n", argv[i]);
+                return 1;
+            }
+            pass = (FsrEmuPass)p;
+        }
+        else if (strcmp(argv[i], "--input") == 0 && i + 2 < argc)
+        {
+            inputWidth = atoi(argv[++i]);
+            inputHeight = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--output") == 0 && i + 2 < argc)
+        {
+            outputWidth = atoi(argv[++i]);
+            outputHeight = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--cache") == 0 && i + 3 < argc)
+        {
+            cacheKb = (uint32_t)atoi(argv[++i]);
+            cacheWays = (uint32_t)atoi(argv[++i]);
+            lineBytes = (uint32_t)atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--bpp") == 0 && i + 1 < argc)
+        {
+            bpp = (uint32_t)atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--line") == 0 && i + 1 < argc)
+        {
+            lineBytes = (uint32_t)atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--wave") == 0 && i + 1 < argc)
+        {
+            waveSize = (uint32_t)atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--coalesce") == 0 && i + 1 < argc)
+        {
+            coalesce = (uint32_t)atoi(argv[++i]);
+        }
+        else
+        {
+            printf("Usage: %s [--pass easu|rcas|bilinear] [--input w h] [--output w h] [--cache kb ways line] [--bpp bytes] [--line bytes] [--wave 32|64] [--coalesce lanes]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // RCAS runs at display resolution.
+    if (pass == FSR_EMU_RCAS)
+    {
+        inputWidth = outputWidth;
+        inputHeight = outputHeight;
+    }
+    if (inputWidth <= 0 || inputHeight <= 0 || outputWidth <= 0 || outputHeight <= 0 || bpp == 0 || lineBytes == 0 || coalesce == 0)
+    {
+        printf("Invalid arguments\n");
+        return 1;
+    }
+
+    FsrEmuCurrFilter filter;
+    filter.OnCreate(pass, inputWidth, inputHeight, outputWidth, outputHeight);
+
+    printf("pass %s, %dx%d -> %dx%d, %u workgroups, wave%u, %u lanes per lookup, %uB lines\n", s_fsrEmuPassNames[pass], inputWidth, inputHeight, outputWidth, outputHeight,
+        ((outputWidth + 15) / 16) * ((outputHeight + 15) / 16), waveSize, coalesce, lineBytes);
+    printf("%-12s %10s %10s %10s %12s %10s", "remap", "texels/wg", "reuse/wg", "lines/wg", "lines/instr", "reuse");
+    if (cacheKb)
+        printf(" %10s %12s", "hit rate", "bytes/pixel");
+    printf("\n");
+
+    for (int r = 0; r < FSR_EMU_REMAP_COUNT; r++)
+    {
+        FsrEmuTexCache cache;
+        if (cacheKb)
+            cache.OnCreate(cacheKb * 1024, cacheWays, lineBytes, bpp, (uint32_t)inputWidth);
+
+        FsrEmuDispatchDesc desc;
+        desc.remap = (FsrEmuRemap)r;
+        desc.outputWidth = outputWidth;
+        desc.outputHeight = outputHeight;
+        desc.waveSize = waveSize;
+        desc.coalesceLanes = coalesce;
+        desc.lineBytes = lineBytes;
+        desc.bytesPerTexel = bpp;
+        desc.pCache = cacheKb ? &cache : NULL;
+        FsrEmuStats stats = FsrEmuDispatch(filter, desc);
+
+        // 'reuse' is texel requests per distinct texel over the whole dispatch.
+        double wgs = (double)stats.workgroups;
+        printf("%-12s %10.1f %10.2f %10.1f %12.2f %10.2f", s_fsrEmuRemapNames[r],
+            stats.uniqueTexelsPerWg / wgs,
+            (double)stats.texelRequests / (double)stats.uniqueTexelsPerWg,
+            stats.uniqueLinesPerWg / wgs,
+            (double)stats.lineRequests / (double)stats.instructions,
+            (double)stats.texelRequests / (double)stats.uniqueTexels);
+        if (cacheKb)
+        {
+            double lookups = (double)(stats.cacheHits + stats.cacheMisses);
+            printf(" %9.2f%% %12.3f", 100.0 * stats.cacheHits / lookups, (double)stats.cacheMisses * lineBytes / (double)stats.outputPixels);
+        }
+        printf("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,155 @@
+// FidelityFX Super Resolution Tools
+//
+// Copyright (c) 2021 Advanced Micro Devices, Inc. All rights reserved.
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Measures throughput and maximum relative error of each CPU reciprocal precision tier (see 'ARcpTierF1()' in ffx_a.h).
+//
+// Usage: fsr_rcp_bench [--gate <max relative error>]
+//   With '--gate' the fastest tier whose maximum error passes the gate is reported last.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define A_SSE
+#endif
+
+#define A_CPU
+#include "ffx_a.h"
+
+static const char *s_tierNames[] = { "fast", "medium", "exact" };
+
+static void RcpArray(float *d, const float *a, AU1 n, AU1 tier)
+{
+    // Literal tiers so each call site gets its own specialized loop.
+    switch (tier)
+    {
+        case A_RCP_FAST:   ARcpTierArrayF1(d, a, n, A_RCP_FAST); break;
+        case A_RCP_MEDIUM: ARcpTierArrayF1(d, a, n, A_RCP_MEDIUM); break;
+        default:           ARcpTierArrayF1(d, a, n, A_RCP_EXACT); break;
+    }
+}
+
+// Walks the bit patterns of all positive floats in [2^-60, 2^60] with a stride, in chunks.
+static double MaxRelativeError(AU1 tier)
+{
+    const AU1 chunk = 4096;
+    const AU1 stride = 7;
+    std::vector<float> in(chunk), out(chunk);
+    double maxErr = 0.0;
+    AU1 u = AU1_AF1(ldexpf(1.0f, -60));
+    const AU1 end = AU1_AF1(ldexpf(1.0f, 60));
+    while (u < end)
+    {
+        AU1 n = 0;
+        for (; n < chunk && u < end; n++, u += stride)
+            in[n] = AF1_AU1(u);
+        RcpArray(out.data(), in.data(), n, tier);
+        for (AU1 i = 0; i < n; i++)
+        {
+            double ref = 1.0 / (double)in[i];
+            double err = fabs(((double)out[i] - ref) / ref);
+            if (err > maxErr)
+                maxErr = err;
+        }
+    }
+    return maxErr;
+}
+
+// Cache resident working set, repeated until enough time has passed to be stable.
+static double Throughput(AU1 tier)
+{
+    const AU1 n = 16 * 1024;
+    std::vector<float> in(n), out(n);
+    for (AU1 i = 0; i < n; i++)
+        in[i] = 0.5f + (float)i / (float)n * 1000.0f;
+
+    typedef std::chrono::high_resolution_clock Clock;
+    uint64_t count = 0;
+    float sink = 0.0f;
+    Clock::time_point start = Clock::now();
+    double seconds = 0.0;
+    do
+    {
+        for (int rep = 0; rep < 64; rep++)
+        {
+            RcpArray(out.data(), in.data(), n, tier);
+            sink += out[rep];
+        }
+        count += 64 * (uint64_t)n;
+        seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    } while (seconds < 0.25);
+
+    if (sink == 0.0f)
+        printf(" ");
+    return (double)count / seconds * 1e-6;
+}
+
+int main(int argc, char **argv)
+{
+    double gate = -1.0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--gate") == 0 && i + 1 < argc)
+            gate = atof(argv[++i]);
+        else
+        {
+            printf("Usage: %s [--gate <max relative error>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+#ifdef A_SSE
+    printf("SSE path\n");
+#else
+    printf("Scalar bit trick path\n");
+#endif
+    printf("%-8s %14s %14s %10s\n", "tier", "Mrcp/s", "max rel err", "bits");
+
+    int best = -1;
+    double bestRate = 0.0;
+    for (AU1 tier = A_RCP_FAST; tier <= A_RCP_EXACT; tier++)
+    {
+        double err = MaxRelativeError(tier);
+        double rate = Throughput(tier);
+        double bits = err > 0.0 ? -log2(err) : 24.0;
+        printf("%-8s %14.1f %14.3e %10.1f\n", s_tierNames[tier], rate, err, bits);
+        if (gate >= 0.0 && err <= gate && rate > bestRate)
+        {
+            best = (int)tier;
+            bestRate = rate;
+        }
+    }
+
+    if (gate >= 0.0)
+    {
+        if (best < 0)
+        {
+            printf("No tier passes max relative error %.3e\n", gate);
+            return 2;
+        }
+        printf("Fastest tier passing %.3e: %s\n", gate, s_tierNames[best]);
+    }
+    return 0;
+}